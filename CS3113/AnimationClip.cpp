@@ -0,0 +1,67 @@
+#include "AnimationClip.h"
+#include <sstream>
+
+/**
+ * Slices every frame listed in `animationAtlas` out of the sprite sheet up
+ * front. Directions without an entry fall back to the `RIGHT` frames.
+ * 
+ * @param region the part of the texture holding the sprite sheet.
+ * @param spriteSheetDimensions rows and columns of the sheet, in that order.
+ * @param animationAtlas frame indices to play for each direction.
+ */
+AnimationClip::AnimationClip(Rectangle region, Vector2 spriteSheetDimensions, 
+    const std::map<Direction, std::vector<int>> &animationAtlas) : 
+    mAnimationAtlas {animationAtlas}
+{
+    int rows = (int) spriteSheetDimensions.x;
+    int cols = (int) spriteSheetDimensions.y;
+
+    for (int d = 0; d < DIRECTION_COUNT; d++)
+    {
+        std::map<Direction, std::vector<int>>::const_iterator indices = 
+            animationAtlas.find((Direction) d);
+        if (indices == animationAtlas.end()) indices = animationAtlas.find(RIGHT);
+
+        mFirstFrame[d] = (int) mFrames.size();
+        mFrameCount[d] = 0;
+        if (indices == animationAtlas.end()) continue;
+
+        for (size_t i = 0; i < indices->second.size(); i++)
+        {
+            mFrames.push_back(getUVRectangle(region, indices->second[i], rows, cols));
+            mFrameCount[d]++;
+        }
+    }
+}
+
+/**
+ * Returns the clip for a sprite sheet and frame layout, building it the first
+ * time it is asked for. Clips live until the program exits.
+ */
+const AnimationClip *AnimationClip::shared(const std::string &textureFilepath,
+    Rectangle region, Vector2 spriteSheetDimensions, 
+    const std::map<Direction, std::vector<int>> &animationAtlas)
+{
+    static std::map<std::string, AnimationClip> clips;
+
+    std::ostringstream key;
+    key << textureFilepath << '|' << region.x << ',' << region.y << ',' 
+        << region.width << ',' << region.height << '|' 
+        << spriteSheetDimensions.x << 'x' << spriteSheetDimensions.y;
+
+    for (std::map<Direction, std::vector<int>>::const_iterator it = 
+         animationAtlas.begin(); it != animationAtlas.end(); ++it)
+    {
+        key << '|' << it->first << ':';
+        for (size_t i = 0; i < it->second.size(); i++) key << it->second[i] << ',';
+    }
+
+    std::map<std::string, AnimationClip>::iterator found = clips.find(key.str());
+    if (found == clips.end())
+    {
+        found = clips.insert(std::make_pair(key.str(), 
+            AnimationClip(region, spriteSheetDimensions, animationAtlas))).first;
+    }
+
+    return &found->second;
+}
@@ -0,0 +1,42 @@
+#ifndef ANIMATION_CLIP_H
+#define ANIMATION_CLIP_H
+
+#include "EntityStore.h"
+
+/**
+ * Immutable, precomputed animation table for one sprite sheet: the source
+ * rectangle of every frame of every direction, laid out back to back. Clips
+ * are built once through `AnimationClip::shared()` and reused by every entity
+ * animating the same sheet, so playing an animation is just indexing into
+ * this table.
+ */
+class AnimationClip
+{
+private:
+    static constexpr int DIRECTION_COUNT = 4;
+
+    std::vector<Rectangle> mFrames;
+    int mFirstFrame[DIRECTION_COUNT];
+    int mFrameCount[DIRECTION_COUNT];
+
+    // Kept so the clip can be rebuilt for the sheet's new region if its
+    // texture moves (e.g. once a pending atlas is packed)
+    std::map<Direction, std::vector<int>> mAnimationAtlas;
+
+public:
+    AnimationClip(Rectangle region, Vector2 spriteSheetDimensions, 
+        const std::map<Direction, std::vector<int>> &animationAtlas);
+
+    static const AnimationClip *shared(const std::string &textureFilepath,
+        Rectangle region, Vector2 spriteSheetDimensions, 
+        const std::map<Direction, std::vector<int>> &animationAtlas);
+
+    const std::map<Direction, std::vector<int>> &getAnimationAtlas() const
+        { return mAnimationAtlas; }
+    int getFrameCount(Direction direction) const 
+        { return mFrameCount[direction]; }
+    const Rectangle &getFrame(Direction direction, int frameIndex) const 
+        { return mFrames[mFirstFrame[direction] + frameIndex]; }
+};
+
+#endif // ANIMATION_CLIP_H
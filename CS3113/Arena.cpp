@@ -0,0 +1,90 @@
+#include "Arena.h"
+#include <stdlib.h>
+
+constexpr size_t Arena::DEFAULT_BLOCK_SIZE;
+
+/**
+ * @param capacity bytes to reserve up front; zero waits for the first
+ * allocation.
+ */
+Arena::Arena(size_t capacity)
+{
+    if (capacity > 0) addBlock(capacity);
+}
+
+void Arena::addBlock(size_t minimumCapacity)
+{
+    size_t capacity = minimumCapacity > DEFAULT_BLOCK_SIZE ?
+        minimumCapacity : DEFAULT_BLOCK_SIZE;
+
+    Block block = { (unsigned char *) malloc(capacity), capacity };
+    if (block.memory == NULL) return;
+
+    mBlocks.push_back(block);
+    mUsed = 0;
+}
+
+void Arena::freeBlocks()
+{
+    for (const Block &block : mBlocks) free(block.memory);
+    mBlocks.clear();
+}
+
+/**
+ * Returns `size` bytes aligned to `alignment` (a power of two), valid until
+ * the next `reset()`. Chains on a new block if the current one is full.
+ *
+ * @return NULL only if the system is out of memory.
+ */
+void *Arena::allocate(size_t size, size_t alignment)
+{
+    if (!mBlocks.empty())
+    {
+        const Block &block = mBlocks.back();
+        size_t start = (mUsed + alignment - 1) & ~(alignment - 1);
+
+        if (start + size <= block.capacity)
+        {
+            mTotalUsed += start + size - mUsed;
+            mUsed       = start + size;
+            if (mTotalUsed > mPeak) mPeak = mTotalUsed;
+            return block.memory + start;
+        }
+    }
+
+    // The tail of the full block is wasted; count it so the merged block
+    // on reset() is big enough to fit this pass without chaining
+    if (!mBlocks.empty()) mTotalUsed += mBlocks.back().capacity - mUsed;
+
+    size_t blockCount = mBlocks.size();
+    addBlock(size + alignment);
+    if (mBlocks.size() == blockCount) return NULL;
+
+    return allocate(size, alignment);
+}
+
+/**
+ * Frees everything allocated so far. Chained blocks are merged into one the
+ * size of the busiest pass yet, so the next pass fits without chaining.
+ */
+void Arena::reset()
+{
+    if (mBlocks.size() > 1)
+    {
+        size_t capacity = getCapacity();
+        if (mPeak > capacity) capacity = mPeak;
+
+        freeBlocks();
+        addBlock(capacity);
+    }
+
+    mUsed      = 0;
+    mTotalUsed = 0;
+}
+
+size_t Arena::getCapacity() const
+{
+    size_t capacity = 0;
+    for (const Block &block : mBlocks) capacity += block.capacity;
+    return capacity;
+}
@@ -0,0 +1,67 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "cs3113.h"
+#include <cstddef>
+
+/**
+ * Bump allocator for data that all dies at once: a level's entities, or one
+ * step's scratch lists. `allocate()` just advances an offset into a block,
+ * and `reset()` frees everything in one go. Nothing is destroyed, so only
+ * trivially destructible data should go in directly (see `Pool` for objects
+ * that need their destructors run).
+ *
+ * When a block fills up another is chained on. On the next `reset()` they
+ * are merged into one block big enough for all of them, so after a warm-up
+ * pass the same work never touches the heap again.
+ *
+ * Not thread-safe: give each thread its own arena, or allocate up front
+ * before handing the memory out.
+ */
+class Arena
+{
+private:
+    struct Block
+    {
+        unsigned char *memory;
+        size_t         capacity;
+    };
+
+    std::vector<Block> mBlocks;
+    size_t mUsed      = 0;   // bytes used in the last block
+    size_t mTotalUsed = 0;   // bytes used in earlier blocks, plus mUsed
+    size_t mPeak      = 0;
+
+    void addBlock(size_t minimumCapacity);
+    void freeBlocks();
+
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit Arena(size_t capacity = 0);
+    ~Arena() { freeBlocks(); }
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    void reset();
+
+    /**
+     * Uninitialised room for `count` objects of a trivially destructible
+     * type; the arena never runs destructors.
+     */
+    template <typename T>
+    T *allocateArray(int count)
+    {
+        return (T *) allocate(sizeof(T) * (size_t) (count > 0 ? count : 0),
+            alignof(T));
+    }
+
+    size_t getUsed()       const { return mTotalUsed;          }
+    size_t getPeak()       const { return mPeak;               }
+    size_t getCapacity()   const;
+    int    getBlockCount() const { return (int) mBlocks.size(); }
+};
+
+#endif // ARENA_H
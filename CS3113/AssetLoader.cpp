@@ -0,0 +1,95 @@
+#include "AssetLoader.h"
+#include "BakedTexture.h"
+#include <algorithm>
+#include <chrono>
+
+/**
+ * Begins decoding `filepaths` in the background. Any earlier batch is
+ * finished (and its untaken images freed) first.
+ *
+ * @param threadCount decoding threads to start. Negative picks one per
+ * hardware thread; the loader always starts at least one, and never more
+ * than there are files, so the caller is never the one decoding.
+ */
+void AssetLoader::start(const char *const *filepaths, int count,
+    int threadCount)
+{
+    finish();
+
+    mFilepaths.assign(filepaths, filepaths + count);
+    mNextIndex.store(0);
+    mDecodedCount.store(0);
+    mDecodeNanoseconds.store(0);
+    mTakenCount = 0;
+
+    if (threadCount < 0) threadCount = (int) std::thread::hardware_concurrency();
+    threadCount = std::max(1, std::min(threadCount, count));
+
+    for (int i = 0; i < threadCount && count > 0; i++)
+        mThreads.push_back(std::thread(&AssetLoader::decodeLoop, this));
+}
+
+/**
+ * Claims files one at a time until every file has been claimed, so a thread
+ * that finishes a small image early moves straight on to the next one.
+ */
+void AssetLoader::decodeLoop()
+{
+    int index;
+    while ((index = mNextIndex.fetch_add(1)) < (int) mFilepaths.size())
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        LoadedImage loaded = { mFilepaths[index], {} };
+#ifndef HEADLESS
+        loaded.image = LoadImagePreferBaked(mFilepaths[index].c_str());
+#endif
+
+        mDecodeNanoseconds.fetch_add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count());
+
+        {
+            std::lock_guard<std::mutex> lock(mCompletedMutex);
+            mCompleted.push_back(loaded);
+        }
+        mDecodedCount.fetch_add(1);
+    }
+}
+
+/**
+ * Moves every image decoded since the last call onto the end of `images`,
+ * in the order they finished, without waiting for the rest. The caller owns
+ * them from then on. A file that failed to decode comes back with no data.
+ *
+ * @return the number of images appended.
+ */
+int AssetLoader::takeCompleted(std::vector<LoadedImage> &images)
+{
+    std::lock_guard<std::mutex> lock(mCompletedMutex);
+
+    images.insert(images.end(), mCompleted.begin(), mCompleted.end());
+    int taken = (int) mCompleted.size();
+    mCompleted.clear();
+
+    mTakenCount += taken;
+    return taken;
+}
+
+/**
+ * Waits for the decoding threads to exit and frees any images nobody took.
+ */
+void AssetLoader::finish()
+{
+    // Stop handing out files that haven't been started yet
+    mNextIndex.store((int) mFilepaths.size());
+
+    for (std::thread &thread : mThreads) thread.join();
+    mThreads.clear();
+
+#ifndef HEADLESS
+    for (const LoadedImage &loaded : mCompleted)
+        if (loaded.image.data != NULL) UnloadImage(loaded.image);
+#endif
+    mCompleted.clear();
+}
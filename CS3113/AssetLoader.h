@@ -0,0 +1,63 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include "cs3113.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+/**
+ * Decodes image files on background threads so the main thread stays free to
+ * draw while assets load. Only CPU-side work (reading a baked texture, or
+ * decoding the source image if there is none) happens off the main thread;
+ * the decoded images are collected with `takeCompleted()` and uploaded by the
+ * caller, since GPU calls must stay on the thread that owns the window.
+ *
+ * Unlike `JobSystem::parallelFor()`, `start()` returns immediately: the
+ * loader runs its own threads and nothing waits on them until `finish()`.
+ *
+ * In headless builds nothing is decoded and every load completes at once
+ * with an empty image.
+ */
+class AssetLoader
+{
+public:
+    struct LoadedImage
+    {
+        std::string filepath;
+        Image       image;
+    };
+
+private:
+    std::vector<std::string> mFilepaths;
+    std::vector<std::thread> mThreads;
+
+    std::atomic<int> mNextIndex{0};
+    std::atomic<int> mDecodedCount{0};
+    std::atomic<long long> mDecodeNanoseconds{0};
+    int mTakenCount = 0;
+
+    std::mutex mCompletedMutex;
+    std::vector<LoadedImage> mCompleted;
+
+    void decodeLoop();
+
+public:
+    AssetLoader() { }
+    ~AssetLoader() { finish(); }
+
+    AssetLoader(const AssetLoader &) = delete;
+    AssetLoader &operator=(const AssetLoader &) = delete;
+
+    void start(const char *const *filepaths, int count, int threadCount = -1);
+    int takeCompleted(std::vector<LoadedImage> &images);
+    void finish();
+
+    bool isDone()          const { return mTakenCount == getTotalCount();  }
+    int  getTotalCount()   const { return (int) mFilepaths.size();         }
+    int  getDecodedCount() const { return mDecodedCount.load();            }
+    int  getThreadCount()  const { return (int) mThreads.size();           }
+    double getDecodeSeconds() const { return mDecodeNanoseconds.load() * 1e-9; }
+};
+
+#endif // ASSET_LOADER_H
@@ -0,0 +1,115 @@
+#include "BakedTexture.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/**
+ * Maps a source image to its baked file: same name with a .tex extension,
+ * in a `baked/` directory next to it.
+ */
+std::string GetBakedTexturePath(const char *sourceFilepath)
+{
+    std::string path = sourceFilepath;
+
+    size_t slash = path.find_last_of("/\\");
+    std::string directory = slash == std::string::npos ? "" :
+        path.substr(0, slash + 1);
+    std::string name = slash == std::string::npos ? path :
+        path.substr(slash + 1);
+
+    size_t dot = name.find_last_of('.');
+    if (dot != std::string::npos) name.erase(dot);
+
+    return directory + "baked/" + name + ".tex";
+}
+
+/**
+ * Reads the baked version of `sourceFilepath` with a single read.
+ *
+ * @param image receives the pixels on success; free them with
+ * `UnloadImage()`.
+ *
+ * @return false if there is no baked file, it is older than the source
+ * (the source was edited after baking), or it is malformed.
+ */
+bool LoadBakedImage(const char *sourceFilepath, Image *image)
+{
+    std::string bakedFilepath = GetBakedTexturePath(sourceFilepath);
+
+    struct stat baked, source;
+    if (stat(bakedFilepath.c_str(), &baked) != 0) return false;
+    if (stat(sourceFilepath, &source) == 0 && source.st_mtime > baked.st_mtime)
+        return false;
+    if (baked.st_size < (off_t) sizeof(BakedTextureTrailer)) return false;
+
+    FILE *file = fopen(bakedFilepath.c_str(), "rb");
+    if (!file) return false;
+
+    size_t size = (size_t) baked.st_size;
+    unsigned char *buffer = (unsigned char *) malloc(size);
+    bool isRead = buffer && fread(buffer, 1, size, file) == size;
+    fclose(file);
+
+    BakedTextureTrailer trailer;
+    if (isRead)
+        memcpy(&trailer, buffer + size - sizeof(trailer), sizeof(trailer));
+
+    if (!isRead || trailer.magic != BAKED_TEXTURE_MAGIC ||
+        trailer.version != BAKED_TEXTURE_VERSION ||
+        trailer.trailerSize != sizeof(BakedTextureTrailer) ||
+        trailer.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 ||
+        trailer.width <= 0 || trailer.height <= 0 ||
+        (uint64_t) trailer.width * trailer.height * 4 != trailer.dataSize ||
+        (uint64_t) trailer.dataSize + sizeof(trailer) != size)
+    {
+        free(buffer);
+        return false;
+    }
+
+    image->data    = buffer;
+    image->width   = trailer.width;
+    image->height  = trailer.height;
+    image->mipmaps = 1;
+    image->format  = trailer.format;
+    return true;
+}
+
+/**
+ * Writes `image`, which must already be R8G8B8A8, as a baked texture.
+ */
+bool SaveBakedImage(const char *bakedFilepath, Image image)
+{
+    if (image.data == NULL || image.format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8)
+        return false;
+
+    BakedTextureTrailer trailer;
+    trailer.dataSize    = (uint32_t) image.width * image.height * 4;
+    trailer.width       = image.width;
+    trailer.height      = image.height;
+    trailer.format      = image.format;
+    trailer.version     = BAKED_TEXTURE_VERSION;
+    trailer.trailerSize = sizeof(BakedTextureTrailer);
+    trailer.magic       = BAKED_TEXTURE_MAGIC;
+
+    FILE *file = fopen(bakedFilepath, "wb");
+    if (!file) return false;
+
+    bool isWritten =
+        fwrite(image.data, 1, trailer.dataSize, file) == trailer.dataSize &&
+        fwrite(&trailer, sizeof(trailer), 1, file) == 1;
+
+    return fclose(file) == 0 && isWritten;
+}
+
+#ifndef HEADLESS
+/**
+ * Loads the baked version of an image if there is an up-to-date one, and
+ * decodes the source file otherwise.
+ */
+Image LoadImagePreferBaked(const char *sourceFilepath)
+{
+    Image image;
+    if (LoadBakedImage(sourceFilepath, &image)) return image;
+    return LoadImage(sourceFilepath);
+}
+#endif // HEADLESS
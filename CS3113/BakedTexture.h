@@ -0,0 +1,43 @@
+#ifndef BAKED_TEXTURE_H
+#define BAKED_TEXTURE_H
+
+#include "cs3113.h"
+#include <stdint.h>
+
+/**
+ * Baked textures (.tex) are images that tools/texture_baker.cpp has already
+ * decoded, scaled down to the largest size the game ever draws them at and
+ * converted to the pixel format the GPU takes, so loading one is a single
+ * read with nothing to decode.
+ *
+ * The pixels come first and a `BakedTextureTrailer` ends the file. Reading
+ * the whole file into one allocation therefore leaves the pixels at its
+ * start, where `UnloadImage()` can free them like any other image.
+ *
+ * A baked file lives in a `baked/` directory beside its source image, e.g.
+ * assets/owl.png bakes to assets/baked/owl.tex.
+ */
+
+static const uint32_t BAKED_TEXTURE_MAGIC   = 0x54333143; // "C13T"
+static const uint16_t BAKED_TEXTURE_VERSION = 1;
+
+struct BakedTextureTrailer
+{
+    uint32_t dataSize;      // bytes of pixels before the trailer
+    int32_t  width;
+    int32_t  height;
+    int32_t  format;        // `PixelFormat`, always R8G8B8A8 for now
+    uint16_t version;
+    uint16_t trailerSize;
+    uint32_t magic;
+};
+
+static_assert(sizeof(BakedTextureTrailer) == 24,
+    "BakedTextureTrailer layout changed");
+
+std::string GetBakedTexturePath(const char *sourceFilepath);
+bool LoadBakedImage(const char *sourceFilepath, Image *image);
+bool SaveBakedImage(const char *bakedFilepath, Image image);
+Image LoadImagePreferBaked(const char *sourceFilepath);
+
+#endif // BAKED_TEXTURE_H
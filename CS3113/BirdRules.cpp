@@ -0,0 +1,125 @@
+#include "BirdRules.h"
+#include "Entity.h"
+
+/**
+ * Applies one sample of player input to the bird's fuel and horizontal
+ * thrust. A jump costs `Entity::fuel_decrement` whether or not there was
+ * enough fuel for it; a held thruster costs as much every
+ * `Entity::FUEL_BURN_INTERVAL` seconds.
+ *
+ * @param input bitmask of `InputFlag`s.
+ * @param deltaTime time covered by this sample.
+ * @param fuelAccumulator seconds the thruster has burned since it last
+ * cost fuel.
+ *
+ * @return true if the bird jumps this step.
+ */
+bool ApplyBirdInput(unsigned char input, float deltaTime, int &fuel, 
+    float &fuelAccumulator, float &accelerationX)
+{
+    bool isJumping = false;
+    if (input & INPUT_JUMP)
+    {
+        isJumping = fuel > 1;
+        fuel -= Entity::fuel_decrement;
+        if (fuel < 0) fuel = 0;
+    }
+
+    bool moving = false;
+    if (input & INPUT_LEFT)
+    {
+        if (fuel > 0) 
+        { 
+            accelerationX = -Entity::HORIZONTAL_ACCELERATION; 
+            moving = true; 
+        }
+    }
+    else if (input & INPUT_RIGHT)
+    {
+        if (fuel > 0) 
+        { 
+            accelerationX =  Entity::HORIZONTAL_ACCELERATION; 
+            moving = true; 
+        }
+    }
+    else accelerationX = 0.0f;
+
+    if (moving)
+    {
+        fuelAccumulator += deltaTime;
+        if (fuelAccumulator >= Entity::FUEL_BURN_INTERVAL)
+        {
+            fuel -= Entity::fuel_decrement;
+            if (fuel < 0) fuel = 0;
+            fuelAccumulator = 0.0f;
+        }
+    }
+    else fuelAccumulator = 0.0f;
+
+    return isJumping;
+}
+
+/**
+ * Keeps the bird on screen after its step: the sides and top bounce it
+ * back, the bottom stops it where it fell out.
+ *
+ * @return false if the bird fell out of the bottom, which loses.
+ */
+bool ConfineToScreen(Vector2 &position, Vector2 &velocity, Vector2 dimensions,
+    float bounciness)
+{
+    float halfWidth  = dimensions.x / 2.0f;
+    float halfHeight = dimensions.y / 2.0f;
+
+    if (position.x - halfWidth < 0)
+    {
+        position.x = halfWidth;
+        velocity.x = -velocity.x * bounciness;
+    }
+    else if (position.x + halfWidth > SCREEN_WIDTH)
+    {
+        position.x = SCREEN_WIDTH - halfWidth;
+        velocity.x = -velocity.x * bounciness;
+    }
+
+    if (position.y - halfHeight < 0)
+    {
+        position.y = halfHeight;
+        velocity.y = -velocity.y * bounciness;
+    }
+    else if (position.y + halfHeight > SCREEN_HEIGHT)
+    {
+        position.y = SCREEN_HEIGHT - halfHeight;
+        velocity   = { 0.0f, 0.0f };
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Decides the episode from the sensor contacts the bird's step made: the
+ * nest's sensor (see levels/level1.txt) wins when the bird is falling onto
+ * it, a hawk's loses, and losing takes precedence.
+ *
+ * @param types each contact's `other`'s `EntityType`, indexed by it.
+ * @param velocity the bird's velocity once it has been confined to the
+ * screen.
+ */
+EpisodeOutcome JudgeContacts(const ContactList &contacts, 
+    const unsigned char *types, Vector2 velocity)
+{
+    bool touchedNest = false, touchedEnemy = false;
+    for (int i = 0; i < contacts.count; i++)
+    {
+        const Contact &contact = contacts.contacts[i];
+        if (contact.kind != CONTACT_SENSOR) continue;
+
+        if (types[contact.other] == PLATFORM)   touchedNest  = true;
+        else if (types[contact.other] == ENEMY) touchedEnemy = true;
+    }
+
+    if (touchedEnemy)                   return EPISODE_LOST;
+    if (touchedNest && velocity.y >= 0) return EPISODE_WON;
+    return EPISODE_RUNNING;
+}
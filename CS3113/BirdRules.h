@@ -0,0 +1,23 @@
+#ifndef BIRD_RULES_H
+#define BIRD_RULES_H
+
+#include "Collision.h"
+#include "constants.h"
+
+// How an episode ended, as judged by `JudgeContacts()` and the screen edges
+enum EpisodeOutcome { EPISODE_RUNNING, EPISODE_WON, EPISODE_LOST };
+
+/**
+ * The rules of the game for the bird, over plain values so that the game
+ * (main.cpp) and `VecEnv` play by the same ones. Moving the bird is
+ * `StepBody()`; these decide what it is told to do before the step and what
+ * became of it after.
+ */
+bool ApplyBirdInput(unsigned char input, float deltaTime, int &fuel, 
+    float &fuelAccumulator, float &accelerationX);
+bool ConfineToScreen(Vector2 &position, Vector2 &velocity, Vector2 dimensions,
+    float bounciness);
+EpisodeOutcome JudgeContacts(const ContactList &contacts, 
+    const unsigned char *types, Vector2 velocity);
+
+#endif // BIRD_RULES_H
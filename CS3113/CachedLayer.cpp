@@ -0,0 +1,64 @@
+#include "CachedLayer.h"
+
+#ifndef HEADLESS
+
+/**
+ * Creates the layer's render texture, replacing any previous one; the layer
+ * starts out stale.
+ *
+ * @return false if the texture could not be created.
+ */
+bool CachedLayer::load(int width, int height)
+{
+    unload();
+    mTarget = LoadRenderTexture(width, height);
+    return mTarget.id != 0;
+}
+
+void CachedLayer::unload()
+{
+    if (mTarget.id != 0) UnloadRenderTexture(mTarget);
+
+    mTarget      = {};
+    mHasContents = false;
+}
+
+/**
+ * Starts redrawing the layer for `key`: draws until `end()` go into the
+ * layer, in its own coordinates, on top of `clearColor`.
+ */
+void CachedLayer::begin(int key, Color clearColor)
+{
+    BeginTextureMode(mTarget);
+    ClearBackground(clearColor);
+
+    mKey         = key;
+    mHasContents = true;
+    mRedrawCount++;
+}
+
+void CachedLayer::end()
+{
+    EndTextureMode();
+}
+
+/**
+ * Composites the layer with its top-left corner at `position`, pixel for
+ * pixel. Render textures are stored upside down, hence the negative source
+ * height.
+ */
+void CachedLayer::draw(Vector2 position, Color tint) const
+{
+    if (!mHasContents) return;
+
+    Rectangle source = { 0.0f, 0.0f, (float) mTarget.texture.width, 
+                         (float) -mTarget.texture.height };
+    DrawTextureRec(mTarget.texture, source, position, tint);
+}
+
+#else
+
+bool CachedLayer::load(int, int) { return false; }
+void CachedLayer::unload() { }
+
+#endif // HEADLESS
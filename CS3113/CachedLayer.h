@@ -0,0 +1,52 @@
+#ifndef CACHED_LAYER_H
+#define CACHED_LAYER_H
+
+#include "cs3113.h"
+
+/**
+ * One layer of the frame kept in a render texture, so whatever it shows is
+ * rasterised once and then composited each frame with a single 1:1 blit.
+ * A layer remembers the key it was last drawn for (a fuel level, a game
+ * state); callers redraw it only when `isStale()` says the key has moved
+ * on, and otherwise just `draw()` it.
+ *
+ *     if (layer.isStale(fuel)) {
+ *         layer.begin(fuel);
+ *         DrawText(...);
+ *         layer.end();
+ *     }
+ *     layer.draw(position);
+ *
+ * Redraw between frames, not between `BeginDrawing()` and `EndDrawing()`.
+ * Nothing is drawn in headless builds.
+ */
+class CachedLayer
+{
+private:
+    RenderTexture2D mTarget = {};
+    int  mKey         = 0;
+    bool mHasContents = false;
+    int  mRedrawCount = 0;
+
+public:
+    CachedLayer() { }
+    ~CachedLayer() { unload(); }
+
+    CachedLayer(const CachedLayer &) = delete;
+    CachedLayer &operator=(const CachedLayer &) = delete;
+
+    bool load(int width, int height);
+    void unload();
+
+    void begin(int key, Color clearColor = BLANK);
+    void end();
+    void draw(Vector2 position, Color tint = WHITE) const;
+
+    bool isLoaded() const { return mTarget.id != 0; }
+    bool isStale(int key) const { return !mHasContents || key != mKey; }
+    int  getRedrawCount() const { return mRedrawCount; }
+    int  getWidth()  const { return mTarget.texture.width;  }
+    int  getHeight() const { return mTarget.texture.height; }
+};
+
+#endif // CACHED_LAYER_H
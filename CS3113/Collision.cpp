@@ -0,0 +1,348 @@
+#include "Collision.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COLLISION_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(COLLISION_X86) && (defined(__GNUC__) || defined(__clang__))
+#define COLLISION_TARGET_AVX2 __attribute__((target("avx2")))
+#define COLLISION_HAS_AVX2 1
+#endif
+
+static inline int countBits(unsigned int bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount(bits);
+#else
+    int count = 0;
+    for (; bits != 0; bits &= bits - 1) count++;
+    return count;
+#endif
+}
+
+static CollisionKernel detectKernel()
+{
+#if defined(COLLISION_HAS_AVX2)
+    if (__builtin_cpu_supports("avx2")) return KERNEL_AVX2;
+#endif
+#if defined(COLLISION_X86)
+    return KERNEL_SSE;
+#else
+    return KERNEL_SCALAR;
+#endif
+}
+
+static CollisionKernel gKernel = detectKernel();
+
+CollisionKernel GetCollisionKernel() { return gKernel; }
+
+/**
+ * Forces a particular kernel, e.g. to compare them. Requests for an
+ * instruction set the CPU lacks fall back to the best supported one.
+ */
+void SetCollisionKernel(CollisionKernel kernel)
+{
+    CollisionKernel best = detectKernel();
+    gKernel = kernel > best ? best : kernel;
+}
+
+const char *GetCollisionKernelName(CollisionKernel kernel)
+{
+    switch (kernel)
+    {
+        case KERNEL_AVX2: return "avx2";
+        case KERNEL_SSE:  return "sse";
+        default:          return "scalar";
+    }
+}
+
+static int overlapRangeScalar(Vector2 position, Vector2 dimensions, 
+    const Vector2 *positions, const Vector2 *dimensionsArray, int begin, 
+    int count, unsigned int *hitMask, float *xOverlaps, float *yOverlaps)
+{
+    int hits = 0;
+
+    for (int i = begin; i < count; i++)
+    {
+        if (BoxOverlap(position, dimensions, positions[i], dimensionsArray[i], 
+                       &xOverlaps[i], &yOverlaps[i]))
+        {
+            hitMask[i >> 5] |= 1u << (i & 31);
+            hits++;
+        }
+    }
+
+    return hits;
+}
+
+#if defined(COLLISION_X86)
+/**
+ * Four boxes per iteration. Each pair of loads holds four interleaved
+ * `Vector2`s, which are split into x and y lanes with two shuffles.
+ */
+static int overlapRangeSSE(Vector2 position, Vector2 dimensions, 
+    const Vector2 *positions, const Vector2 *dimensionsArray, int count, 
+    unsigned int *hitMask, float *xOverlaps, float *yOverlaps)
+{
+    const __m128 px      = _mm_set1_ps(position.x);
+    const __m128 py      = _mm_set1_ps(position.y);
+    const __m128 dx      = _mm_set1_ps(dimensions.x);
+    const __m128 dy      = _mm_set1_ps(dimensions.y);
+    const __m128 half    = _mm_set1_ps(0.5f);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    const __m128 zero    = _mm_setzero_ps();
+
+    int hits = 0;
+    int i    = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 p0 = _mm_loadu_ps(&positions[i].x);
+        __m128 p1 = _mm_loadu_ps(&positions[i + 2].x);
+        __m128 d0 = _mm_loadu_ps(&dimensionsArray[i].x);
+        __m128 d1 = _mm_loadu_ps(&dimensionsArray[i + 2].x);
+
+        __m128 bx = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 by = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 bw = _mm_shuffle_ps(d0, d1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 bh = _mm_shuffle_ps(d0, d1, _MM_SHUFFLE(3, 1, 3, 1));
+
+        __m128 xOverlap = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(dx, bw), half), 
+                                     _mm_and_ps(_mm_sub_ps(px, bx), absMask));
+        __m128 yOverlap = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(dy, bh), half), 
+                                     _mm_and_ps(_mm_sub_ps(py, by), absMask));
+
+        _mm_storeu_ps(&xOverlaps[i], xOverlap);
+        _mm_storeu_ps(&yOverlaps[i], yOverlap);
+
+        unsigned int bits = (unsigned int) _mm_movemask_ps(_mm_and_ps(
+            _mm_cmpgt_ps(xOverlap, zero), _mm_cmpgt_ps(yOverlap, zero)));
+
+        hitMask[i >> 5] |= bits << (i & 31);
+        hits += countBits(bits);
+    }
+
+    return hits + overlapRangeScalar(position, dimensions, positions, 
+        dimensionsArray, i, count, hitMask, xOverlaps, yOverlaps);
+}
+#endif
+
+#if defined(COLLISION_HAS_AVX2)
+/**
+ * Eight boxes per iteration. In-lane shuffles leave the x (or y) values in
+ * the order 0 1 4 5 2 3 6 7, which a cross-lane permute puts back in order.
+ */
+COLLISION_TARGET_AVX2
+static int overlapRangeAVX2(Vector2 position, Vector2 dimensions, 
+    const Vector2 *positions, const Vector2 *dimensionsArray, int count, 
+    unsigned int *hitMask, float *xOverlaps, float *yOverlaps)
+{
+    const __m256 px      = _mm256_set1_ps(position.x);
+    const __m256 py      = _mm256_set1_ps(position.y);
+    const __m256 dx      = _mm256_set1_ps(dimensions.x);
+    const __m256 dy      = _mm256_set1_ps(dimensions.y);
+    const __m256 half    = _mm256_set1_ps(0.5f);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    const __m256 zero    = _mm256_setzero_ps();
+
+    int hits = 0;
+    int i    = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256 p0 = _mm256_loadu_ps(&positions[i].x);
+        __m256 p1 = _mm256_loadu_ps(&positions[i + 4].x);
+        __m256 d0 = _mm256_loadu_ps(&dimensionsArray[i].x);
+        __m256 d1 = _mm256_loadu_ps(&dimensionsArray[i + 4].x);
+
+        __m256 bx = _mm256_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 by = _mm256_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1));
+        __m256 bw = _mm256_shuffle_ps(d0, d1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m256 bh = _mm256_shuffle_ps(d0, d1, _MM_SHUFFLE(3, 1, 3, 1));
+
+        bx = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(bx), _MM_SHUFFLE(3, 1, 2, 0)));
+        by = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(by), _MM_SHUFFLE(3, 1, 2, 0)));
+        bw = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(bw), _MM_SHUFFLE(3, 1, 2, 0)));
+        bh = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(bh), _MM_SHUFFLE(3, 1, 2, 0)));
+
+        __m256 xOverlap = _mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(dx, bw), half), 
+                                        _mm256_and_ps(_mm256_sub_ps(px, bx), absMask));
+        __m256 yOverlap = _mm256_sub_ps(_mm256_mul_ps(_mm256_add_ps(dy, bh), half), 
+                                        _mm256_and_ps(_mm256_sub_ps(py, by), absMask));
+
+        _mm256_storeu_ps(&xOverlaps[i], xOverlap);
+        _mm256_storeu_ps(&yOverlaps[i], yOverlap);
+
+        unsigned int bits = (unsigned int) _mm256_movemask_ps(_mm256_and_ps(
+            _mm256_cmp_ps(xOverlap, zero, _CMP_GT_OQ), 
+            _mm256_cmp_ps(yOverlap, zero, _CMP_GT_OQ)));
+
+        hitMask[i >> 5] |= bits << (i & 31);
+        hits += countBits(bits);
+    }
+
+    // The scalar tail is SSE-encoded; clearing the upper halves before it
+    // runs spares it an AVX-to-SSE transition penalty
+    _mm256_zeroupper();
+
+    return hits + overlapRangeScalar(position, dimensions, positions, 
+        dimensionsArray, i, count, hitMask, xOverlaps, yOverlaps);
+}
+#endif
+
+/**
+ * Tests one box against `count` packed boxes in a single pass, using the
+ * widest instruction set available (see `SetCollisionKernel()`). Results are
+ * identical to calling `BoxOverlap()` on every pair.
+ * 
+ * @param position centre of the box being tested.
+ * @param dimensions full size of the box being tested.
+ * @param positions centres of the boxes to test against.
+ * @param dimensionsArray full sizes of the boxes to test against.
+ * @param count number of boxes in `positions` and `dimensionsArray`.
+ * @param hitMask receives one bit per box, set on overlap; must hold
+ * `HitMaskWords(count)` words and is cleared first.
+ * @param xOverlaps receives each box's x-axis overlap (positive on overlap).
+ * @param yOverlaps receives each box's y-axis overlap (positive on overlap).
+ * 
+ * @return the number of overlapping boxes.
+ */
+int BoxOverlapBatch(Vector2 position, Vector2 dimensions, 
+    const Vector2 *positions, const Vector2 *dimensionsArray, int count, 
+    unsigned int *hitMask, float *xOverlaps, float *yOverlaps)
+{
+    for (int w = 0; w < HitMaskWords(count); w++) hitMask[w] = 0u;
+
+    switch (gKernel)
+    {
+#if defined(COLLISION_HAS_AVX2)
+        case KERNEL_AVX2:
+            return overlapRangeAVX2(position, dimensions, positions, 
+                dimensionsArray, count, hitMask, xOverlaps, yOverlaps);
+#endif
+#if defined(COLLISION_X86)
+        case KERNEL_SSE:
+            return overlapRangeSSE(position, dimensions, positions, 
+                dimensionsArray, count, hitMask, xOverlaps, yOverlaps);
+#endif
+        default:
+            return overlapRangeScalar(position, dimensions, positions, 
+                dimensionsArray, 0, count, hitMask, xOverlaps, yOverlaps);
+    }
+}
+
+/**
+ * Reference implementation of `BoxOverlapBatch()` that never uses SIMD.
+ */
+int BoxOverlapBatchScalar(Vector2 position, Vector2 dimensions, 
+    const Vector2 *positions, const Vector2 *dimensionsArray, int count, 
+    unsigned int *hitMask, float *xOverlaps, float *yOverlaps)
+{
+    for (int w = 0; w < HitMaskWords(count); w++) hitMask[w] = 0u;
+
+    return overlapRangeScalar(position, dimensions, positions, 
+        dimensionsArray, 0, count, hitMask, xOverlaps, yOverlaps);
+}
+
+/**
+ * Tests every box in A against every box in B, one batch per row.
+ * 
+ * @param hitMatrix receives `countA` rows of `HitMaskWords(countB)` words;
+ * bit j of row i is set when A[i] overlaps B[j].
+ * @param xScratch,yScratch at least `countB` floats each, overwritten.
+ * 
+ * @return the total number of overlapping pairs.
+ */
+int BoxOverlapMatrix(const Vector2 *positionsA, const Vector2 *dimensionsA, 
+    int countA, const Vector2 *positionsB, const Vector2 *dimensionsB, 
+    int countB, unsigned int *hitMatrix, float *xScratch, float *yScratch)
+{
+    int words = HitMaskWords(countB);
+    int hits  = 0;
+
+    for (int i = 0; i < countA; i++)
+    {
+        hits += BoxOverlapBatch(positionsA[i], dimensionsA[i], positionsB, 
+            dimensionsB, countB, hitMatrix + (size_t) i * words, xScratch, 
+            yScratch);
+    }
+
+    return hits;
+}
+
+/**
+ * Takes room for `contactCapacity` contacts from `arena`, valid until the
+ * arena is reset, and empties the list.
+ * 
+ * @return false if the arena is out of memory, leaving no room at all.
+ */
+bool ContactList::allocate(Arena &arena, int contactCapacity)
+{
+    contacts = arena.allocateArray<Contact>(contactCapacity);
+    count    = 0;
+    capacity = contacts ? contactCapacity : 0;
+    return contacts != nullptr;
+}
+
+/**
+ * Takes room for up to `candidateCapacity` candidates from `arena`; the
+ * arrays are valid until the arena is reset. There is room for every
+ * contact one entity's step can produce: a swept stop and a push-out per
+ * candidate on each axis, and a sensor contact per candidate.
+ * 
+ * @return false if the arena is out of memory, leaving no room at all.
+ */
+bool CollisionScratch::allocate(Arena &arena, int candidateCapacity)
+{
+    handles          = arena.allocateArray<EntityHandle>(candidateCapacity);
+    positions        = arena.allocateArray<Vector2>(candidateCapacity);
+    dimensions       = arena.allocateArray<Vector2>(candidateCapacity);
+    sensorDimensions = arena.allocateArray<Vector2>(candidateCapacity);
+    velocities       = arena.allocateArray<Vector2>(candidateCapacity);
+    xOverlaps        = arena.allocateArray<float>(candidateCapacity);
+    yOverlaps        = arena.allocateArray<float>(candidateCapacity);
+    hitMask          = arena.allocateArray<unsigned int>(HitMaskWords(candidateCapacity));
+    contacts.allocate(arena, 3 * candidateCapacity + 2);
+
+    bool isAllocated = handles && positions && dimensions && 
+        sensorDimensions && velocities && xOverlaps && yOverlaps && hitMask &&
+        contacts.contacts;
+    capacity    = isAllocated ? candidateCapacity : 0;
+    sensorCount = 0;
+    if (!isAllocated) contacts.capacity = 0;
+    return isAllocated;
+}
+
+/**
+ * Copies the active entities among `candidates` into the packed arrays ready
+ * for `BoxOverlapBatch()`, remembering which handle each slot came from.
+ * Positions and velocities come from the store's snapshot while one is
+ * held. Candidates past `capacity` are dropped.
+ * 
+ * @return the number of packed candidates.
+ */
+int CollisionScratch::gather(const EntityStore &store, 
+    const EntityHandle *candidates, int count)
+{
+    const Vector2 *storePositions  = store.getCollisionPositions();
+    const Vector2 *storeVelocities = store.getCollisionVelocities();
+    int packed = 0;
+    sensorCount = 0;
+
+    for (int i = 0; i < count && packed < capacity; i++)
+    {
+        EntityHandle handle = candidates[i];
+        if (!store.isActive(handle)) continue;
+
+        handles[packed]          = handle;
+        positions[packed]        = storePositions[handle];
+        dimensions[packed]       = store.colliderDimensions[handle];
+        sensorDimensions[packed] = store.sensorDimensions[handle];
+        velocities[packed]       = storeVelocities[handle];
+        sensorCount += store.sensorDimensions[handle].x > 0.0f;
+        packed++;
+    }
+
+    return packed;
+}
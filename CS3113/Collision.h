@@ -0,0 +1,139 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include "Arena.h"
+#include "EntityStore.h"
+
+// Instruction set used by `BoxOverlapBatch()`
+enum CollisionKernel { KERNEL_SCALAR, KERNEL_SSE, KERNEL_AVX2 };
+
+/**
+ * Penetration depth of two centre/size boxes along each axis. Both overlaps
+ * are positive exactly when the boxes intersect. This is the single
+ * definition of the AABB test: the batch kernels below reproduce it bit for
+ * bit, and `Entity::isColliding()` and the game rules are built on it.
+ */
+inline bool BoxOverlap(Vector2 positionA, Vector2 dimensionsA, 
+    Vector2 positionB, Vector2 dimensionsB, float *xOverlap, float *yOverlap)
+{
+    *xOverlap = (dimensionsA.x + dimensionsB.x) * 0.5f - 
+                fabsf(positionA.x - positionB.x);
+    *yOverlap = (dimensionsA.y + dimensionsB.y) * 0.5f - 
+                fabsf(positionA.y - positionB.y);
+
+    return *xOverlap > 0.0f && *yOverlap > 0.0f;
+}
+
+/**
+ * Swept test along one axis: a box whose centre moves from `start` by
+ * `motion` against a box centred at `other`, `halfExtents` being the sum of
+ * their half sizes on that axis. The boxes must already overlap on the other
+ * axis, which the move doesn't change.
+ *
+ * @param contact receives the coordinate where the moving box first touches
+ * the other one; the time of impact is `(contact - start) / motion`, in
+ * [0, 1).
+ *
+ * @return true if the box starts clear of the other one, on the side it
+ * moves from, and reaches it during the move however far it goes, so thin
+ * colliders can't be skipped over by a long step. A box that starts inside
+ * is not reported; `BoxOverlap()` at the end position handles that.
+ */
+inline bool SweepAxis(float start, float motion, float other, 
+    float halfExtents, float *contact)
+{
+    if (motion > 0.0f)
+    {
+        *contact = other - halfExtents;
+        return start <= *contact && start + motion > *contact;
+    }
+    if (motion < 0.0f)
+    {
+        *contact = other + halfExtents;
+        return start >= *contact && start + motion < *contact;
+    }
+    return false;
+}
+
+inline bool IsHit(const unsigned int *hitMask, int index)
+{
+    return (hitMask[index >> 5] >> (index & 31)) & 1u;
+}
+
+inline int HitMaskWords(int count) { return (count + 31) / 32; }
+
+int BoxOverlapBatch(Vector2 position, Vector2 dimensions, 
+    const Vector2 *positions, const Vector2 *dimensionsArray, int count, 
+    unsigned int *hitMask, float *xOverlaps, float *yOverlaps);
+int BoxOverlapBatchScalar(Vector2 position, Vector2 dimensions, 
+    const Vector2 *positions, const Vector2 *dimensionsArray, int count, 
+    unsigned int *hitMask, float *xOverlaps, float *yOverlaps);
+int BoxOverlapMatrix(const Vector2 *positionsA, const Vector2 *dimensionsA, 
+    int countA, const Vector2 *positionsB, const Vector2 *dimensionsB, 
+    int countB, unsigned int *hitMatrix, float *xScratch, float *yScratch);
+
+CollisionKernel GetCollisionKernel();
+void SetCollisionKernel(CollisionKernel kernel);
+const char *GetCollisionKernelName(CollisionKernel kernel);
+
+// Whether a `Contact` was resolved, or only reported to the game rules
+enum ContactKind { CONTACT_SOLID, CONTACT_SENSOR };
+
+/**
+ * One touching pair found by the collision stage. Solid contacts are the
+ * surfaces `entity` was stopped by or pushed out of; sensor contacts are
+ * the other entity's sensor volumes its collider overlaps once it has
+ * moved, which nothing resolves.
+ */
+struct Contact
+{
+    EntityHandle  entity;             // the entity that moved
+    EntityHandle  other;
+    Vector2       normal;             // unit axis pointing away from `other`
+    float         penetration;        // depth along `normal`
+    Vector2       relativeVelocity;   // `entity`'s minus `other`'s
+    unsigned char kind;               // `ContactKind`
+};
+
+/**
+ * Fixed-capacity run of contacts in a per-step `Arena`. Contacts past the
+ * capacity are dropped.
+ */
+struct ContactList
+{
+    Contact *contacts = nullptr;
+    int      count    = 0;
+    int      capacity = 0;
+
+    bool allocate(Arena &arena, int capacity);
+    void add(const Contact &contact)
+        { if (count < capacity) contacts[count++] = contact; }
+};
+
+/**
+ * Packed arrays of one entity's collision candidates, in the layout the
+ * batch kernel wants, plus the contacts found against them. The arrays live
+ * in a per-step `Arena`, so checking collisions never allocates and nothing
+ * is kept between steps.
+ */
+struct CollisionScratch
+{
+    EntityHandle *handles          = nullptr;
+    Vector2      *positions        = nullptr;
+    Vector2      *dimensions       = nullptr;
+    Vector2      *sensorDimensions = nullptr;
+    Vector2      *velocities       = nullptr;
+    float        *xOverlaps        = nullptr;
+    float        *yOverlaps        = nullptr;
+    unsigned int *hitMask          = nullptr;
+    int           capacity         = 0;
+    // How many of the packed candidates have a sensor volume
+    int           sensorCount      = 0;
+    ContactList   contacts;
+
+    bool allocate(Arena &arena, int capacity);
+    int gather(const EntityStore &store, const EntityHandle *candidates, 
+        int count);
+};
+
+#endif // COLLISION_H
@@ -0,0 +1,93 @@
+#include "DrawCallCounter.h"
+
+#ifndef HEADLESS
+
+// Creates the batch to count through; needs the window to exist
+void DrawCallCounter::load()
+{
+    unload();
+    mBatch    = rlLoadRenderBatch(1, RL_DEFAULT_BATCH_BUFFER_ELEMENTS);
+    mIsLoaded = true;
+}
+
+void DrawCallCounter::unload()
+{
+    if (!mIsLoaded) return;
+    if (mIsCounting) rlSetRenderBatchActive(NULL);
+
+    rlUnloadRenderBatch(mBatch);
+    mBatch      = {};
+    mIsLoaded   = false;
+    mIsCounting = false;
+}
+
+/**
+ * Starts counting a frame. Anything already queued in raylib's batch is
+ * flushed first, uncounted.
+ */
+void DrawCallCounter::begin()
+{
+    if (!mIsLoaded) return;
+
+    rlSetRenderBatchActive(&mBatch);
+    mIsCounting    = true;
+    mDrawCalls     = 0;
+    mFlushes       = 0;
+    mSeenDraws     = 0;
+    mSeenEntries   = 0;
+    mSeenLastCount = 0;
+}
+
+/**
+ * Looks at the batch's draw list. If it has shrunk since the last sample,
+ * rlgl flushed it in between and submitted the draws seen then.
+ */
+void DrawCallCounter::sample()
+{
+    if (!mIsCounting) return;
+
+    int entries   = mBatch.drawCounter;
+    int lastCount = mBatch.draws[entries - 1].vertexCount;
+
+    if (entries < mSeenEntries ||
+        (entries == mSeenEntries && lastCount < mSeenLastCount))
+    {
+        mDrawCalls += mSeenDraws;
+        mFlushes++;
+    }
+
+    // New entries are only started once the current one has vertices, so
+    // only the last can be empty
+    mSeenDraws     = lastCount > 0 ? entries : entries - 1;
+    mSeenEntries   = entries;
+    mSeenLastCount = lastCount;
+}
+
+/**
+ * Flushes the frame's remaining draws, counts them and hands drawing back
+ * to raylib's own batch. The totals are what `getDrawCalls()` and
+ * `getFlushes()` report until the next `end()`.
+ */
+void DrawCallCounter::end()
+{
+    if (!mIsCounting) return;
+
+    sample();
+    if (mSeenDraws > 0)
+    {
+        mDrawCalls += mSeenDraws;
+        mFlushes++;
+    }
+    rlSetRenderBatchActive(NULL);
+    mIsCounting = false;
+
+    mFrameDrawCalls = mDrawCalls;
+    mFrameFlushes   = mFlushes;
+}
+
+#else
+
+void DrawCallCounter::load() { }
+void DrawCallCounter::unload() { }
+
+#endif // HEADLESS
@@ -0,0 +1,65 @@
+#ifndef DRAW_CALL_COUNTER_H
+#define DRAW_CALL_COUNTER_H
+
+#include "cs3113.h"
+
+/**
+ * Counts the draw calls rlgl issues over a frame, as opposed to guessing
+ * them from texture changes. raylib's own batch is private to rlgl, so
+ * between `begin()` and `end()` everything is drawn into a batch of the
+ * same size that this owns, whose draw list can be read. Each flush submits
+ * one draw call per non-empty entry in that list; the empty one rlgl leaves
+ * at the end of a full list draws nothing and isn't counted.
+ *
+ * rlgl flushes by itself when the batch fills up, and reading the list only
+ * notices that on the next `sample()`. Call it after any draw that could
+ * fill the batch, so nothing drawn since the previous sample is missed.
+ *
+ *     BeginDrawing();
+ *     counter.begin();
+ *     ...                  // every draw of the frame, with sample()s
+ *     counter.end();
+ *     EndDrawing();
+ *
+ * Nothing is counted in headless builds.
+ */
+class DrawCallCounter
+{
+private:
+#ifndef HEADLESS
+    rlRenderBatch mBatch = {};
+#endif
+    bool mIsLoaded   = false;
+    bool mIsCounting = false;
+
+    // The frame in progress
+    int mDrawCalls     = 0;
+    int mFlushes       = 0;
+    int mSeenDraws     = 0;   // non-empty entries at the last sample
+    int mSeenEntries   = 0;
+    int mSeenLastCount = 0;   // vertices in the last entry then
+
+    // The last frame `end()` finished
+    int mFrameDrawCalls = 0;
+    int mFrameFlushes   = 0;
+
+public:
+    DrawCallCounter() { }
+    ~DrawCallCounter() { unload(); }
+
+    DrawCallCounter(const DrawCallCounter &) = delete;
+    DrawCallCounter &operator=(const DrawCallCounter &) = delete;
+
+    void load();
+    void unload();
+
+    void begin();
+    void sample();
+    void end();
+
+    bool isLoaded()      const { return mIsLoaded;       }
+    int  getDrawCalls()  const { return mFrameDrawCalls; }
+    int  getFlushes()    const { return mFrameFlushes;   }
+};
+
+#endif // DRAW_CALL_COUNTER_H
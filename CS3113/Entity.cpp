@@ -1,142 +1,107 @@
 #include "Entity.h"
-
-Entity::Entity() : mPosition {0.0f, 0.0f}, mMovement {0.0f, 0.0f}, 
-                   mVelocity {0.0f, 0.0f}, mAcceleration {0.0f, 0.0f},
-                   mScale {DEFAULT_SIZE, DEFAULT_SIZE},
-                   mColliderDimensions {DEFAULT_SIZE, DEFAULT_SIZE}, 
-                   mTexture {}, mTextureType {SINGLE}, mAngle {0.0f},
-                   mSpriteSheetDimensions {}, mDirection {RIGHT}, 
-                   mAnimationAtlas {{}}, mAnimationIndices {}, mFrameSpeed {0},
-                   mEntityType {NONE} { }
-
-Entity::Entity(Vector2 position, Vector2 scale, const char *textureFilepath, 
-    EntityType entityType) : mPosition {position}, mVelocity {0.0f, 0.0f}, 
-    mAcceleration {0.0f, 0.0f}, mScale {scale}, mMovement {0.0f, 0.0f}, 
-    mColliderDimensions {scale}, mTexture {LoadTexture(textureFilepath)}, 
-    mTextureType {SINGLE}, mDirection {RIGHT}, mAnimationAtlas {{}}, 
-    mAnimationIndices {}, mFrameSpeed {0}, mSpeed {DEFAULT_SPEED}, 
-    mAngle {0.0f}, mEntityType {entityType} { }
-
-Entity::Entity(Vector2 position, Vector2 scale, const char *textureFilepath, 
-        TextureType textureType, Vector2 spriteSheetDimensions, std::map<Direction, 
-        std::vector<int>> animationAtlas, EntityType entityType) : 
-        mPosition {position}, mVelocity {0.0f, 0.0f}, 
-        mAcceleration {0.0f,39.8f}, mMovement { 0.0f, 0.0f }, mScale {scale},
-        mColliderDimensions {scale}, mTexture {LoadTexture(textureFilepath)}, 
+#include "Physics.h"
+#include "Profiler.h"
+
+constexpr int   Entity::MAX_FUEL;
+constexpr float Entity::FUEL_BURN_INTERVAL;
+constexpr float Entity::GRAVITY;
+constexpr float Entity::DEFAULT_JUMPING_POWER;
+constexpr float Entity::DEFAULT_BOUNCINESS;
+
+Entity::Entity(EntityStore *store) : mStore {store}, 
+    mHandle {store->create({0.0f, 0.0f}, {DEFAULT_SIZE, DEFAULT_SIZE}, NONE)},
+    mMovement {0.0f, 0.0f}, mScale {DEFAULT_SIZE, DEFAULT_SIZE},
+    mTexture {}, mTextureRegion {}, mTextureType {SINGLE}, mAngle {0.0f},
+    mSpriteSheetDimensions {}, mDirection {RIGHT}, 
+    mFrameSpeed {0} { }
+
+Entity::Entity(EntityStore *store, Vector2 position, Vector2 scale, 
+    const char *textureFilepath, EntityType entityType) : mStore {store}, 
+    mHandle {store->create(position, scale, entityType)}, mScale {scale}, 
+    mMovement {0.0f, 0.0f}, 
+    mTexture {TextureCache::shared().acquire(textureFilepath)}, 
+    mTextureFilepath {textureFilepath},
+    mTextureRegion {TextureCache::shared().getRegion(textureFilepath)},
+    mTextureType {SINGLE}, mDirection {RIGHT}, mFrameSpeed {0}, 
+    mSpeed {DEFAULT_SPEED}, 
+    mAngle {0.0f} { }
+
+Entity::Entity(EntityStore *store, Vector2 position, Vector2 scale, 
+        const char *textureFilepath, TextureType textureType, 
+        Vector2 spriteSheetDimensions, const std::map<Direction, 
+        std::vector<int>> &animationAtlas, EntityType entityType) : 
+        mStore {store}, mHandle {store->create(position, scale, entityType)},
+        mMovement { 0.0f, 0.0f }, mScale {scale},
+        mTexture {TextureCache::shared().acquire(textureFilepath)}, 
+        mTextureFilepath {textureFilepath},
+        mTextureRegion {TextureCache::shared().getRegion(textureFilepath)},
         mTextureType {ATLAS}, mSpriteSheetDimensions {spriteSheetDimensions},
-        mAnimationAtlas {animationAtlas}, mDirection {RIGHT},
-        mAnimationIndices {animationAtlas.at(RIGHT)}, 
-        mFrameSpeed {DEFAULT_FRAME_SPEED}, mAngle { 0.0f }, 
-        mSpeed { DEFAULT_SPEED }, mEntityType {entityType} { }
+        mAnimationClip {AnimationClip::shared(textureFilepath, mTextureRegion,
+            spriteSheetDimensions, animationAtlas)}, 
+        mRenderClip {mAnimationClip},
+        mDirection {RIGHT}, mAngle { 0.0f }, mSpeed { DEFAULT_SPEED } 
+{ 
+    mStore->accelerations[mHandle] = {0.0f, GRAVITY};
+    setFrameSpeed(DEFAULT_FRAME_SPEED);
+}
 
-Entity::~Entity() { UnloadTexture(mTexture); };
+Entity::~Entity() 
+{ 
+    TextureCache::shared().release(mTextureFilepath.c_str()); 
+    mStore->destroy(mHandle);
+};
 
-/**
- * Iterates through a list of collidable entities, checks for collisions with
- * the player entity, and resolves any vertical overlap by adjusting the 
- * player's position and velocity accordingly.
- * 
- * @param collidableEntities An array of pointers to `Entity` objects that 
- * represent the entities that the current `Entity` instance can potentially
- * collide with. The `collisionCheckCount` parameter specifies the number of
- * entities in the `collidableEntities` array that need to be checked for
- * collision.
- * @param collisionCheckCount The number of entities that the current entity
- * (`Entity`) should check for collisions with. This parameter specifies how
- * many entities are in the `collidableEntities` array that need to be checked
- * for collisions with the current entity.
- */
-void Entity::checkCollisionY(Entity **collidableEntities, int collisionCheckCount)
+void Entity::setTexture(const char *textureFilepath)
 {
-    for (int i = 0; i < collisionCheckCount; i++)
-    {
-        Entity *collidableEntity = collidableEntities[i];
-        
-        if (isColliding(collidableEntity))
-        {
-            float yDistance = fabs(mPosition.y - collidableEntity->mPosition.y);
-            float yOverlap  = fabs(yDistance - (mColliderDimensions.y / 2.0f) - 
-                              (collidableEntity->mColliderDimensions.y / 2.0f));
-            
-            if (mVelocity.y > 0) 
-            {
-                mPosition.y -= yOverlap;
-                mVelocity.y = -mVelocity.y * mBounciness;
-                if (fabs(mVelocity.y) < MIN_BOUNCE_VELOCITY) mVelocity.y = 0.0f;
-                mIsCollidingBottom = true;
-            } else if (mVelocity.y < 0) 
-            {
-                mPosition.y += yOverlap;
-                mVelocity.y = -mVelocity.y * mBounciness;
-                if (fabs(mVelocity.y) < MIN_BOUNCE_VELOCITY) mVelocity.y = 0.0f;
-                mIsCollidingTop = true;
-            }
-        }
-    }
+    std::string previous = mTextureFilepath;
+
+    mTexture         = TextureCache::shared().acquire(textureFilepath);
+    mTextureFilepath = textureFilepath;
+    mTextureRegion   = TextureCache::shared().getRegion(textureFilepath);
+
+    TextureCache::shared().release(previous.c_str());
 }
 
-void Entity::checkCollisionX(Entity **collidableEntities, int collisionCheckCount)
+/**
+ * Looks the entity's texture up again after the cache has changed, e.g.
+ * because a file that was still loading when the entity was created has
+ * since been packed into the atlas. Animated entities get the clip for the
+ * sheet's new region to draw from.
+ *
+ * `render()` does this itself when the cache changes. It only touches what
+ * `render()` reads, so it is safe while another thread steps the entity.
+ */
+void Entity::refreshTexture()
 {
-    for (int i = 0; i < collisionCheckCount; i++)
-    {
-        Entity *collidableEntity = collidableEntities[i];
-        
-        if (isColliding(collidableEntity))
-        {            
-            // When standing on a platform, we're always slightly overlapping
-            // it vertically due to gravity, which causes false horizontal
-            // collision detections. So the solution I dound is only resolve X
-            // collisions if there's significant Y overlap, preventing the 
-            // platform we're standing on from acting like a wall.
-            float yDistance = fabs(mPosition.y - collidableEntity->mPosition.y);
-            float yOverlap  = fabs(yDistance - (mColliderDimensions.y / 2.0f) - (collidableEntity->mColliderDimensions.y / 2.0f));
-
-            if (yOverlap < Y_COLLISION_THRESHOLD) continue;
-
-            float xDistance = fabs(mPosition.x - collidableEntity->mPosition.x);
-            float xOverlap  = fabs(xDistance - (mColliderDimensions.x / 2.0f) - (collidableEntity->mColliderDimensions.x / 2.0f));
-
-            if (mVelocity.x > 0) {
-                mPosition.x     -= xOverlap;
-                mVelocity.x     = -mVelocity.x * mBounciness;
-                if (fabs(mVelocity.x) < MIN_BOUNCE_VELOCITY) mVelocity.x = 0.0f;
-
-                // Collision!
-                mIsCollidingRight = true;
-            } else if (mVelocity.x < 0) {
-                mPosition.x    += xOverlap;
-                mVelocity.x     = -mVelocity.x * mBounciness;
-                if (fabs(mVelocity.x) < MIN_BOUNCE_VELOCITY) mVelocity.x = 0.0f;
- 
-                // Collision!
-                mIsCollidingLeft = true;
-            }
-        }
-    }
+    TextureCache &cache = TextureCache::shared();
+
+    mTexture        = cache.getTexture(mTextureFilepath.c_str());
+    mTextureRegion  = cache.getRegion(mTextureFilepath.c_str());
+    mTextureVersion = cache.getVersion();
+
+    if (mTextureType == ATLAS && mRenderClip)
+        mRenderClip = AnimationClip::shared(mTextureFilepath, mTextureRegion,
+            mSpriteSheetDimensions, mRenderClip->getAnimationAtlas());
 }
 
 /**
  * Checks if two entities are colliding based on their positions and collider 
  * dimensions.
  * 
- * @param other represents another Entity with which you want to check for 
- * collision. It is a pointer to the Entity class.
+ * @param other handle of another entity in the same `EntityStore` with which
+ * you want to check for collision.
  * 
  * @return returns `true` if the two entities are colliding based on their
  * positions and collider dimensions, and `false` otherwise.
  */
-bool Entity::isColliding(Entity *other) const 
+bool Entity::isColliding(EntityHandle other) const 
 {
-    if (!other->isActive()) return false;
-
-    float xDistance = fabs(mPosition.x - other->getPosition().x) - 
-        ((mColliderDimensions.x + other->getColliderDimensions().x) / 2.0f);
-    float yDistance = fabs(mPosition.y - other->getPosition().y) - 
-        ((mColliderDimensions.y + other->getColliderDimensions().y) / 2.0f);
+    if (!mStore->isActive(other)) return false;
 
-    if (xDistance < 0.0f && yDistance < 0.0f) return true;
-
-    return false;
+    float xOverlap, yOverlap;
+    return BoxOverlap(mStore->positions[mHandle], 
+        mStore->colliderDimensions[mHandle], mStore->positions[other], 
+        mStore->colliderDimensions[other], &xOverlap, &yOverlap);
 }
 
 /**
@@ -147,27 +112,124 @@ bool Entity::isColliding(Entity *other) const
  */
 void Entity::animate(float deltaTime)
 {
-    mAnimationIndices = mAnimationAtlas.at(mDirection);
-    
     mAnimationTime += deltaTime;
-    float framesPerSecond = 1.0f / mFrameSpeed;
     
-    if (mAnimationTime >= framesPerSecond)
+    if (mAnimationTime >= mFrameDuration)
     {
-        mAnimationTime -= framesPerSecond;
+        mAnimationTime -= mFrameDuration;
         mCurrentFrameIndex++;
-        mCurrentFrameIndex %= mAnimationIndices.size();
+        if (mCurrentFrameIndex >= mAnimationClip->getFrameCount(mDirection)) 
+            mCurrentFrameIndex = 0;
     }
 }
 
-void Entity::displayCollider() 
+/**
+ * The animation system: advances every entity in `entities`, which must all
+ * be animated (`ATLAS`) ones, so the loop has no texture-type check in it.
+ */
+void Entity::animateAll(Entity *const *entities, int count, float deltaTime)
 {
+    PROFILE(PHASE_ANIMATE);
+    for (int i = 0; i < count; i++) entities[i]->animate(deltaTime);
+}
+
+/**
+ * Blends between the position at the start of the last fixed step and the
+ * current one, so rendering stays smooth when the display refresh rate and
+ * the simulation tick rate differ.
+ * 
+ * @param alpha fraction of a fixed step left in the accumulator, in [0, 1].
+ */
+Vector2 Entity::getInterpolatedPosition(float alpha) const
+{
+    Vector2 current  = mStore->positions[mHandle];
+    Vector2 previous = mStore->previousPositions[mHandle];
+
+    return {
+        previous.x + (current.x - previous.x) * alpha,
+        previous.y + (current.y - previous.y) * alpha
+    };
+}
+
+/**
+ * Returns the size of a box, centred on the entity's current position, that
+ * contains every spot its collider can reach during the next `update()`. Used
+ * to ask the broadphase for collision candidates before moving.
+ * 
+ * @param deltaTime length of the upcoming simulation step in seconds.
+ */
+Vector2 Entity::getBroadphaseDimensions(float deltaTime) const
+{
+    Vector2 velocity     = mStore->velocities[mHandle];
+    Vector2 acceleration = mStore->accelerations[mHandle];
+    Vector2 dimensions   = mStore->colliderDimensions[mHandle];
+
+    float reachX = (fabs(velocity.x) + fabs(acceleration.x) * deltaTime) * 
+                   deltaTime;
+    float reachY = (fabs(velocity.y) + fabs(acceleration.y) * deltaTime + 
+                   (mIsJumping ? mJumpingPower : 0.0f)) * deltaTime;
+
+    // One extra pixel on each side absorbs collision-resolution nudges
+    return {
+        dimensions.x + 2.0f * (reachX + 1.0f),
+        dimensions.y + 2.0f * (reachY + 1.0f)
+    };
+}
+
+/**
+ * Copies out what `render()` needs from this step, so another thread can
+ * draw the entity while the simulation moves on.
+ */
+void Entity::capture(EntityRenderState &state) const
+{
+    state.previousPosition = mStore->previousPositions[mHandle];
+    state.position         = mStore->positions[mHandle];
+    state.angle            = mAngle;
+    state.frameIndex       = mCurrentFrameIndex;
+    state.direction        = (unsigned char) mDirection;
+    state.isActive         = isActive();
+}
+
+/**
+ * Copies out what a step can change on this object itself; the rest of its
+ * per-step state is in the store (see `EntityStore::save()`).
+ */
+void Entity::saveState(EntityState &state) const
+{
+    state.movement      = mMovement;
+    state.animationTime = mAnimationTime;
+    state.frameIndex    = mCurrentFrameIndex;
+    state.fuel          = fuel_level;
+    state.direction     = (unsigned char) mDirection;
+    state.isJumping     = mIsJumping;
+}
+
+// Puts back what `saveState()` copied out
+void Entity::restoreState(const EntityState &state)
+{
+    mMovement          = state.movement;
+    mAnimationTime     = state.animationTime;
+    mCurrentFrameIndex = state.frameIndex;
+    fuel_level         = state.fuel;
+    mDirection         = (Direction) state.direction;
+    mIsJumping         = state.isJumping;
+}
+
+#ifndef HEADLESS
+/**
+ * Outlines the collider where `state` (from `capture()`) puts the entity.
+ */
+void Entity::displayCollider(const EntityRenderState &state, float alpha) 
+{
+    Vector2 position = state.getInterpolatedPosition(alpha);
+    Vector2 dimensions = mStore->colliderDimensions[mHandle];
+
     // draw the collision box
     Rectangle colliderBox = {
-        mPosition.x - mColliderDimensions.x / 2.0f,  
-        mPosition.y - mColliderDimensions.y / 2.0f,  
-        mColliderDimensions.x,                        
-        mColliderDimensions.y                        
+        position.x - dimensions.x / 2.0f,  
+        position.y - dimensions.y / 2.0f,  
+        dimensions.x,                        
+        dimensions.y                        
     };
 
     DrawRectangleLines(
@@ -178,77 +240,152 @@ void Entity::displayCollider()
         GREEN               // Color
     );
 }
+#endif // HEADLESS
 
-void Entity::update(float deltaTime, Entity **collidableEntities, 
-    int collisionCheckCount)
+/**
+ * The physics system for one entity: advances it one step and resolves its
+ * collisions against `collidableEntities`, packing them into scratch arrays
+ * taken from `frameArena`. Reset the arena once the step is over.
+ *
+ * Only physics happens here, and the step itself is `StepBody()`, which
+ * `VecEnv` runs its birds through too. Patrols are
+ * `EntityStore::updatePatrols()` and animation is `animateAll()`, each a
+ * separate loop over just the entities it applies to.
+ *
+ * @param contacts if given, receives the step's contacts (see `Contact`),
+ * valid until the arena is reset.
+ */
+void Entity::update(float deltaTime, const EntityHandle *collidableEntities, 
+    int collisionCheckCount, Arena &frameArena, ContactList *contacts)
 {
-    if(mEntityStatus == INACTIVE) return;
-
-    resetColliderFlags();
+    CollisionScratch collision;
+    collision.allocate(frameArena, collisionCheckCount);
+    update(deltaTime, collidableEntities, collisionCheckCount, collision);
+    if (contacts) *contacts = collision.contacts;
+}
 
-    // Horizontal velocity is driven by acceleration (set via input)
-    mVelocity.x += mAcceleration.x * deltaTime;
+void Entity::update(float deltaTime, const EntityHandle *collidableEntities, 
+    int collisionCheckCount, CollisionScratch &collision)
+{
+    if(!isActive()) return;
 
-    if (fabs(mAcceleration.x) < 0.0001f) {
-        mVelocity.x = mVelocity.x / (1.0f + HORIZONTAL_DAMPING * deltaTime);
+    int candidateCount;
+    {
+        PROFILE(PHASE_INTEGRATE);
+        candidateCount = collision.gather(*mStore, collidableEntities, 
+            collisionCheckCount);
     }
 
-    // Apply vertical acceleration (gravity) to velocity
-    mVelocity.y += mAcceleration.y * deltaTime;
+    Body body;
+    body.position     = mStore->positions[mHandle];
+    body.velocity     = mStore->velocities[mHandle];
+    body.acceleration = mStore->accelerations[mHandle];
+    body.dimensions   = mStore->colliderDimensions[mHandle];
+    body.bounciness   = mBounciness;
+    body.jumpImpulse  = mIsJumping ? mJumpingPower : 0.0f;
+    body.flags        = mStore->flags[mHandle];
+    body.handle       = mHandle;
+
+    StepBody(body, deltaTime, collision, candidateCount);
+
+    mStore->positions[mHandle]  = body.position;
+    mStore->velocities[mHandle] = body.velocity;
+    mStore->flags[mHandle]      = body.flags;
+    mIsJumping = false;
+}
+
+/**
+ * Updates `count` entities at once, spread over the job system's threads.
+ * 
+ * Entity `i` collides against `candidates[candidateStart[i]]` up to (but not
+ * including) `candidates[candidateStart[i + 1]]`. Every entity writes only
+ * its own slots in the store, and takes the other entities' positions from
+ * the store's snapshot, so call this between `EntityStore::takeSnapshot()`
+ * and `releaseSnapshot()`; the result is then the same however the work is
+ * split.
+ * 
+ * Every entity's collision scratch is taken from `frameArena` here, before
+ * any thread starts, since the arena itself isn't thread-safe.
+ *
+ * @param contacts if given, receives every entity's contacts, in entity
+ * order, valid until the arena is reset. This is the step's one contact
+ * list: game rules read what touched what from it rather than testing
+ * pairs again.
+ */
+void Entity::updateParallel(JobSystem &jobs, Entity *const *entities, 
+    int count, const int *candidateStart, const EntityHandle *candidates, 
+    float deltaTime, Arena &frameArena, ContactList *contacts)
+{
+    CollisionScratch *collisions = frameArena.allocateArray<CollisionScratch>(count);
+    if (!collisions) return;
 
-    if (mIsJumping)
+    for (int i = 0; i < count; i++)
     {
-        mIsJumping = false;
-        mVelocity.y -= mJumpingPower;
+        collisions[i] = CollisionScratch();
+        collisions[i].allocate(frameArena, 
+            candidateStart[i + 1] - candidateStart[i]);
     }
 
-    if (mEntityType == PLATFORM || mEntityType == ENEMY) {
-        updatePlatformMovement();
-    }
-    
-    mPosition.y += mVelocity.y * deltaTime;
-    checkCollisionY(collidableEntities, collisionCheckCount);
-    mPosition.x += mVelocity.x * deltaTime;
-    checkCollisionX(collidableEntities, collisionCheckCount);
-    if (mTextureType == ATLAS) {
-        animate(deltaTime);
-    }
+    jobs.parallelFor(count, UPDATE_GRAIN_SIZE, [&](int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+            entities[i]->update(deltaTime, candidates + candidateStart[i], 
+                candidateStart[i + 1] - candidateStart[i], collisions[i]);
+    });
+
+    if (!contacts) return;
+
+    int total = 0;
+    for (int i = 0; i < count; i++) total += collisions[i].contacts.count;
+
+    contacts->allocate(frameArena, total);
+    for (int i = 0; i < count; i++)
+        for (int c = 0; c < collisions[i].contacts.count; c++)
+            contacts->add(collisions[i].contacts.contacts[c]);
 }
 
-void Entity::render()
+#ifndef HEADLESS
+/**
+ * Queues the entity's sprite into `batch` on the entity's render layer, as
+ * `state` (from `capture()`) has it. Everything that changes while the game
+ * runs comes from `state`, so this is safe while another thread steps the
+ * entity. Collider outlines are no longer drawn here; call
+ * `displayCollider()` separately when debugging.
+ *
+ * @param alpha how far to blend from the state's previous position to its
+ * current one, in [0, 1].
+ */
+void Entity::render(SpriteBatch &batch, const EntityRenderState &state, 
+    float alpha)
 {
-    if(mEntityStatus == INACTIVE) return;
+    if(!state.isActive) return;
+
+    if (mTextureVersion != TextureCache::shared().getVersion()) refreshTexture();
+    // Still loading
+    if (mTexture.id == 0) return;
+
+    Vector2 position = state.getInterpolatedPosition(alpha);
 
     Rectangle textureArea;
 
     switch (mTextureType)
     {
         case SINGLE:
-            // Whole texture (UV coordinates)
-            textureArea = {
-                // top-left corner
-                0.0f, 0.0f,
-
-                // bottom-right corner (of texture)
-                static_cast<float>(mTexture.width),
-                static_cast<float>(mTexture.height)
-            };
+            // Whole image (its region of the texture, if packed)
+            textureArea = mTextureRegion;
             break;
         case ATLAS:
-            textureArea = getUVRectangle(
-                &mTexture, 
-                mAnimationIndices[mCurrentFrameIndex], 
-                mSpriteSheetDimensions.x, 
-                mSpriteSheetDimensions.y
-            );
-        
+            // Precomputed when the clip was built
+            textureArea = mRenderClip->getFrame((Direction) state.direction, 
+                state.frameIndex);
+            break;
         default: break;
     }
 
     // Destination rectangle – centred on gPosition
     Rectangle destinationArea = {
-        mPosition.x,
-        mPosition.y,
+        position.x,
+        position.y,
         static_cast<float>(mScale.x),
         static_cast<float>(mScale.y)
     };
@@ -259,12 +396,11 @@ void Entity::render()
         static_cast<float>(mScale.y) / 2.0f
     };
 
-    // Render the texture on screen
-    DrawTexturePro(
+    // Queue the texture for this frame's batch
+    batch.draw(
         mTexture, 
         textureArea, destinationArea, originOffset,
-        mAngle, WHITE
+        state.angle, mRenderLayer
     );
-
-    displayCollider();
-}
\ No newline at end of file
+}
+#endif // HEADLESS
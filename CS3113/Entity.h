@@ -3,66 +3,57 @@
 
 #include "cs3113.h"
 #include "constants.h"
-
-enum Direction    { LEFT, UP, RIGHT, DOWN         }; 
-enum EntityStatus { ACTIVE, INACTIVE              };
-enum EntityType   { PLAYER, BLOCK, PLATFORM,ENEMY, NONE };
+#include "EntityStore.h"
+#include "TextureCache.h"
+#include "SpriteBatch.h"
+#include "AnimationClip.h"
+#include "Collision.h"
+#include "JobSystem.h"
+#include "RenderSnapshot.h"
 
 class Entity
 {
 private:
-    Vector2 mPosition;
-    Vector2 mMovement;
-    Vector2 mVelocity;
-    Vector2 mAcceleration;
-    
-    // Platform and Hawk Enemy specific variables
-    float mPlatformSpeed = 2.0f; 
-    bool mMovingRight = true;   
+    // Hot per-step data (position, velocity, collider, status flags) lives in
+    // the store's parallel arrays; this object only keeps the cold state
+    EntityStore  *mStore;
+    EntityHandle  mHandle;
 
+    Vector2 mMovement;
     Vector2 mScale;
-    Vector2 mColliderDimensions;
     
     Texture2D mTexture;
+    std::string mTextureFilepath;
+    Rectangle mTextureRegion;
+    // `TextureCache::getVersion()` when mTexture and mTextureRegion were
+    // looked up; they are refreshed before drawing once it moves on
+    int mTextureVersion = -1;
     TextureType mTextureType;
+    int mRenderLayer = 0;
     Vector2 mSpriteSheetDimensions;
     
-    std::map<Direction, std::vector<int>> mAnimationAtlas;
-    std::vector<int> mAnimationIndices;
+    // Frame counts for `animate()` on the simulation thread. They don't
+    // depend on where the sheet is packed, so this is never replaced
+    const AnimationClip *mAnimationClip = nullptr;
+    // Frame rectangles for `render()`, rebuilt with mTextureRegion
+    const AnimationClip *mRenderClip    = nullptr;
     Direction mDirection = DOWN;
     int mFrameSpeed;
+    float mFrameDuration = 0.0f;
 
     int mCurrentFrameIndex = 0;
     float mAnimationTime = 0.0f;
 
     bool mIsJumping = false;
-    float mJumpingPower = 100.0f; 
+    float mJumpingPower = DEFAULT_JUMPING_POWER; 
 
     int mSpeed;
     float mAngle;
-    float mBounciness = 0.6f; 
-    int fuel_level =1000;
-    bool mIsCollidingTop    = false;
-    bool mIsCollidingBottom = false;
-    bool mIsCollidingRight  = false;
-    bool mIsCollidingLeft   = false;
-
-    EntityStatus mEntityStatus = ACTIVE;
-    EntityType   mEntityType;
-    
+    float mBounciness = DEFAULT_BOUNCINESS; 
+    int fuel_level = MAX_FUEL;
 
-    bool isColliding(Entity *other) const;
-    void checkCollisionY(Entity **collidableEntities, int collisionCheckCount);
-    void checkCollisionX(Entity **collidableEntities, int collisionCheckCount);
-    void resetColliderFlags() 
-    {
-        mIsCollidingTop    = false;
-        mIsCollidingBottom = false;
-        mIsCollidingRight  = false;
-        mIsCollidingLeft   = false;
-    }
-
-    void animate(float deltaTime);
+    void update(float deltaTime, const EntityHandle *collidableEntities, 
+        int collisionCheckCount, CollisionScratch &collision);
 
 public:
     static constexpr int   DEFAULT_SIZE          = 250;
@@ -73,28 +64,50 @@ public:
     static constexpr float MIN_BOUNCE_VELOCITY   = 50.0f;
     static constexpr float Y_COLLISION_THRESHOLD = 0.5f;
     static constexpr int fuel_decrement = 50;
-
-    Entity();
-    Entity(Vector2 position, Vector2 scale, const char *textureFilepath, 
-        EntityType entityType);
-    Entity(Vector2 position, Vector2 scale, const char *textureFilepath, 
+    static constexpr int   MAX_FUEL              = 1000;
+    // Seconds a horizontal thruster burns before it costs `fuel_decrement`
+    static constexpr float FUEL_BURN_INTERVAL    = 0.2f;
+    static constexpr float GRAVITY               = 39.8f;
+    static constexpr float DEFAULT_JUMPING_POWER = 100.0f;
+    static constexpr float DEFAULT_BOUNCINESS    = 0.6f;
+    static constexpr int UPDATE_GRAIN_SIZE = 64;
+
+    explicit Entity(EntityStore *store);
+    Entity(EntityStore *store, Vector2 position, Vector2 scale, 
+        const char *textureFilepath, EntityType entityType);
+    Entity(EntityStore *store, Vector2 position, Vector2 scale, 
+        const char *textureFilepath, 
         TextureType textureType, Vector2 spriteSheetDimensions, 
-        std::map<Direction, std::vector<int>> animationAtlas, 
+        const std::map<Direction, std::vector<int>> &animationAtlas, 
         EntityType entityType);
     ~Entity();
 
-    void update(float deltaTime, Entity **collidableEntities, int collisionCheckCount);
-    void render();
+    void update(float deltaTime, const EntityHandle *collidableEntities, 
+        int collisionCheckCount, Arena &frameArena, 
+        ContactList *contacts = nullptr);
+    static void updateParallel(JobSystem &jobs, Entity *const *entities, 
+        int count, const int *candidateStart, const EntityHandle *candidates, 
+        float deltaTime, Arena &frameArena, ContactList *contacts = nullptr);
+    void animate(float deltaTime);
+    static void animateAll(Entity *const *entities, int count, 
+        float deltaTime);
+    bool isColliding(EntityHandle other) const;
+    void capture(EntityRenderState &state) const;
+    void saveState(EntityState &state) const;
+    void restoreState(const EntityState &state);
+    void refreshTexture();
+    void render(SpriteBatch &batch, const EntityRenderState &state, 
+        float alpha = 1.0f);
     void normaliseMovement() { Normalise(&mMovement); }
 
     void jump()       { if (fuel_level > 1){mIsJumping = true;}
                         edit_fuel_level();
                      }
-    void activate()   { mEntityStatus  = ACTIVE;   }
-    void deactivate() { mEntityStatus  = INACTIVE; }
-    void displayCollider();
+    void activate()   { mStore->flags[mHandle] |=  FLAG_ACTIVE; }
+    void deactivate() { mStore->flags[mHandle] &= ~FLAG_ACTIVE; }
+    void displayCollider(const EntityRenderState &state, float alpha = 1.0f);
 
-    bool isActive() { return mEntityStatus == ACTIVE ? true : false; }
+    bool isActive() const { return mStore->isActive(mHandle); }
 
     void moveUp()    { mMovement.y = -1; mDirection = UP;    }
     void moveDown()  { mMovement.y =  1; mDirection = DOWN;  }
@@ -103,14 +116,22 @@ public:
 
     void resetMovement() { mMovement = { 0.0f, 0.0f }; }
 
-    Vector2     getPosition()              const { return mPosition;              }
+    EntityHandle getHandle()               const { return mHandle;                }
+    EntityType  getEntityType()            const { return (EntityType) mStore->types[mHandle]; }
+    Vector2     getPosition()              const { return mStore->positions[mHandle];         }
+    Vector2     getPreviousPosition()      const { return mStore->previousPositions[mHandle]; }
+    Vector2     getInterpolatedPosition(float alpha) const;
+    Vector2     getBroadphaseDimensions(float deltaTime) const;
     Vector2     getMovement()              const { return mMovement;              }
-    Vector2     getVelocity()              const { return mVelocity;              }
-    Vector2     getAcceleration()          const { return mAcceleration;          }
+    Vector2     getVelocity()              const { return mStore->velocities[mHandle];        }
+    Vector2     getAcceleration()          const { return mStore->accelerations[mHandle];     }
     Vector2     getScale()                 const { return mScale;                 }
     Vector2     getColliderDimensions()    const { return mScale;                 }
+    Vector2     getSensorDimensions()      const { return mStore->sensorDimensions[mHandle]; }
     Vector2     getSpriteSheetDimensions() const { return mSpriteSheetDimensions; }
     Texture2D   getTexture()               const { return mTexture;               }
+    Rectangle   getTextureRegion()         const { return mTextureRegion;         }
+    int         getRenderLayer()           const { return mRenderLayer;           }
     TextureType getTextureType()           const { return mTextureType;           }
     Direction   getDirection()             const { return mDirection;             }
     int         getFrameSpeed()            const { return mFrameSpeed;            }
@@ -121,68 +142,61 @@ public:
     int         get_fuel_level()           const { return fuel_level;             }
     
     
-    bool isCollidingTop()    const { return mIsCollidingTop;    }
-    bool isCollidingBottom() const { return mIsCollidingBottom; }
+    bool isCollidingTop()    const { return mStore->flags[mHandle] & FLAG_COLLIDING_TOP;    }
+    bool isCollidingBottom() const { return mStore->flags[mHandle] & FLAG_COLLIDING_BOTTOM; }
 
-    std::map<Direction, std::vector<int>> getAnimationAtlas() const { return mAnimationAtlas; }
+    const AnimationClip *getAnimationClip() const { return mAnimationClip; }
 
     void setPosition(Vector2 newPosition)
-        { mPosition = newPosition;                 }
+        { mStore->positions[mHandle] = newPosition;         }
     void setMovement(Vector2 newMovement)
         { mMovement = newMovement;                 }
     void setAcceleration(Vector2 newAcceleration)
-        { mAcceleration = newAcceleration;         }
+        { mStore->accelerations[mHandle] = newAcceleration; }
     void setVelocity(Vector2 newVelocity)
-        { mVelocity = newVelocity;                 }
+        { mStore->velocities[mHandle] = newVelocity;        }
     float getBounciness() const { return mBounciness; }
     void setBounciness(float b) { mBounciness = b; }
     void setScale(Vector2 newScale)
         { mScale = newScale;                       }
-    void setTexture(const char *textureFilepath)
-        { mTexture = LoadTexture(textureFilepath); }
+    void setTexture(const char *textureFilepath);
+    void setRenderLayer(int layer)
+        { mRenderLayer = layer;                    }
     void setColliderDimensions(Vector2 newDimensions) 
-        { mColliderDimensions = newDimensions;     }
+        { mStore->colliderDimensions[mHandle] = newDimensions; }
+    void setSensorDimensions(Vector2 newDimensions) 
+        { mStore->sensorDimensions[mHandle] = newDimensions;   }
     void setSpriteSheetDimensions(Vector2 newDimensions) 
         { mSpriteSheetDimensions = newDimensions;  }
     void setSpeed(int newSpeed)
         { mSpeed  = newSpeed;                      }
     void setFrameSpeed(int newSpeed)
-        { mFrameSpeed = newSpeed;                  }
+        { mFrameSpeed    = newSpeed;
+          mFrameDuration = newSpeed > 0 ? 1.0f / newSpeed : 0.0f; }
     void setJumpingPower(float newJumpingPower)
         { mJumpingPower = newJumpingPower;         }
+    void setJumping(bool isJumping)
+        { mIsJumping = isJumping;                  }
+    void setFuelLevel(int fuel)
+        { fuel_level = fuel;                       }
     void setAngle(float newAngle) 
         { mAngle = newAngle;                       }
     void setEntityType(EntityType entityType)
-        { mEntityType = entityType;                }
+        { mStore->setType(mHandle, entityType);    }
     void edit_fuel_level(){
         fuel_level -= fuel_decrement;
         if (fuel_level < 0) fuel_level = 0;
     }
     void left_movement(){
-        if (fuel_level > 0) mAcceleration.x = -10; 
+        if (fuel_level > 0) mStore->accelerations[mHandle].x = -10; 
     }
     void right_movement(){
-        if (fuel_level > 0) mAcceleration.x = 10; 
-    }
-    
-    // Platform and Enemy movement methods
-    void updatePlatformMovement() {
-        if (mEntityType == PLATFORM||mEntityType == ENEMY) {
-            if (mMovingRight) {
-                mPosition.x += mPlatformSpeed;
-                if (mPosition.x >= SCREEN_WIDTH - mScale.x/2) {
-                    mMovingRight = false;
-                }
-            } else {
-                mPosition.x -= mPlatformSpeed;
-                if (mPosition.x <= mScale.x/2) {
-                    mMovingRight = true;
-                }
-            }
-        }
+        if (fuel_level > 0) mStore->accelerations[mHandle].x = 10; 
     }
     
-    void setPlatformSpeed(float speed) { mPlatformSpeed = speed; }
+    void setPlatformSpeed(float speed) { mStore->platformSpeeds[mHandle] = speed; }
+    void setPatrolPath(PatrolKind kind, const Vector2 *points, int count)
+        { mStore->setPatrolPath(mHandle, kind, points, count); }
 };
 
 
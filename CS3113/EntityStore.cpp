@@ -0,0 +1,317 @@
+#include "EntityStore.h"
+#include <float.h>
+#include <string.h>
+
+constexpr float EntityStore::DEFAULT_PLATFORM_SPEED;
+constexpr float EntityStore::PLATFORM_SPEED_SCALE;
+
+/**
+ * Adds a new entity and returns its handle, reusing a destroyed entity's
+ * slots if there are any and appending to every array otherwise. Handles
+ * stay valid until they are destroyed or `clear()` is called, even when the
+ * arrays grow.
+ */
+EntityHandle EntityStore::create(Vector2 position, Vector2 colliderDimension, 
+    EntityType entityType)
+{
+    if (!mFreeHandles.empty())
+    {
+        EntityHandle handle = mFreeHandles.back();
+        mFreeHandles.pop_back();
+
+        positions[handle]          = position;
+        previousPositions[handle]  = position;
+        velocities[handle]         = { 0.0f, 0.0f };
+        accelerations[handle]      = { 0.0f, 0.0f };
+        colliderDimensions[handle] = colliderDimension;
+        sensorDimensions[handle]   = { 0.0f, 0.0f };
+        platformSpeeds[handle]     = DEFAULT_PLATFORM_SPEED;
+        patrolPaths[handle]        = PatrolPath();
+        types[handle]              = (unsigned char) entityType;
+        flags[handle]              = FLAG_ACTIVE | FLAG_MOVING_RIGHT;
+        mAlive[handle]             = 1;
+        if (isPatrolType(entityType)) addPatrolHandle(handle);
+        return handle;
+    }
+
+    positions.push_back(position);
+    previousPositions.push_back(position);
+    velocities.push_back({ 0.0f, 0.0f });
+    accelerations.push_back({ 0.0f, 0.0f });
+    colliderDimensions.push_back(colliderDimension);
+    sensorDimensions.push_back({ 0.0f, 0.0f });
+    platformSpeeds.push_back(DEFAULT_PLATFORM_SPEED);
+    patrolPaths.push_back(PatrolPath());
+    types.push_back((unsigned char) entityType);
+    flags.push_back(FLAG_ACTIVE | FLAG_MOVING_RIGHT);
+    mAlive.push_back(1);
+
+    EntityHandle handle = (EntityHandle) positions.size() - 1;
+    if (isPatrolType(entityType)) addPatrolHandle(handle);
+    return handle;
+}
+
+/**
+ * Frees an entity's slots for the next `create()`. It stops being active (so
+ * no system visits it) and stops being a platform or enemy (so patrols skip
+ * it). Handles outside the store, e.g. after `clear()`, and handles that
+ * are already destroyed are ignored, so a slot is never freed twice.
+ */
+void EntityStore::destroy(EntityHandle handle)
+{
+    if (!isAlive(handle)) return;
+
+    if (isPatrolType(types[handle])) removePatrolHandle(handle);
+    types[handle]  = NONE;
+    flags[handle]  = 0;
+    mAlive[handle] = 0;
+    mFreeHandles.push_back(handle);
+}
+
+/**
+ * Changes an entity's type, moving it into or out of the patrol system's
+ * working set. Always go through here rather than writing `types`.
+ */
+void EntityStore::setType(EntityHandle handle, EntityType entityType)
+{
+    bool wasPatrol = isPatrolType(types[handle]);
+    bool isPatrol  = isPatrolType(entityType);
+
+    types[handle] = (unsigned char) entityType;
+
+    if (wasPatrol && !isPatrol) removePatrolHandle(handle);
+    else if (isPatrol && !wasPatrol) addPatrolHandle(handle);
+}
+
+/**
+ * Adds `handle` to the patrol list with the default patrol (see
+ * `PatrolRoutes::addEdgeToEdge()`), at its current height and heading right
+ * from where it is now.
+ */
+void EntityStore::addPatrolHandle(EntityHandle handle)
+{
+    float halfWidth = colliderDimensions[handle].x / 2.0f;
+    PatrolPath path = mPatrolRoutes.addEdgeToEdge(halfWidth);
+
+    path.origin = { 0.0f, positions[handle].y };
+    path.phase  = fminf(fmaxf(positions[handle].x - halfWidth, 0.0f), 
+        path.length);
+    patrolPaths[handle] = path;
+    mPatrolHandles.push_back(handle);
+    mPatrolBounds.push_back(getPatrolBounds(handle));
+}
+
+/**
+ * The box every position a patrol can take lies in: its path's bounds,
+ * grown to take in where the entity is now, which is where it stays until
+ * its patrol first runs.
+ */
+Rectangle EntityStore::getPatrolBounds(EntityHandle handle) const
+{
+    Rectangle bounds = mPatrolRoutes.getBounds(patrolPaths[handle]);
+    Vector2 position = positions[handle];
+
+    float right  = fmaxf(bounds.x + bounds.width, position.x);
+    float bottom = fmaxf(bounds.y + bounds.height, position.y);
+    bounds.x      = fminf(bounds.x, position.x);
+    bounds.y      = fminf(bounds.y, position.y);
+    bounds.width  = right - bounds.x;
+    bounds.height = bottom - bounds.y;
+    return bounds;
+}
+
+/**
+ * Replaces a platform's or enemy's patrol with a route through `count`
+ * waypoints, given relative to where it is now, starting at the first.
+ */
+void EntityStore::setPatrolPath(EntityHandle handle, PatrolKind kind, 
+    const Vector2 *points, int count)
+{
+    PatrolPath path = mPatrolRoutes.add(kind, points, count);
+    path.origin = positions[handle];
+    patrolPaths[handle] = path;
+
+    for (size_t i = 0; i < mPatrolHandles.size(); i++)
+        if (mPatrolHandles[i] == handle) mPatrolBounds[i] = getPatrolBounds(handle);
+}
+
+/**
+ * Swap-removes `handle` from the patrol list. Linear, but only run when an
+ * entity stops patrolling, never per step.
+ */
+void EntityStore::removePatrolHandle(EntityHandle handle)
+{
+    for (size_t i = 0; i < mPatrolHandles.size(); i++)
+    {
+        if (mPatrolHandles[i] != handle) continue;
+
+        mPatrolHandles[i] = mPatrolHandles.back();
+        mPatrolHandles.pop_back();
+        mPatrolBounds[i] = mPatrolBounds.back();
+        mPatrolBounds.pop_back();
+        return;
+    }
+}
+
+void EntityStore::reserve(int capacity)
+{
+    positions.reserve(capacity);
+    previousPositions.reserve(capacity);
+    velocities.reserve(capacity);
+    accelerations.reserve(capacity);
+    colliderDimensions.reserve(capacity);
+    sensorDimensions.reserve(capacity);
+    platformSpeeds.reserve(capacity);
+    patrolPaths.reserve(capacity);
+    types.reserve(capacity);
+    flags.reserve(capacity);
+    mAlive.reserve(capacity);
+    mFreeHandles.reserve(capacity);
+    mPatrolHandles.reserve(capacity);
+    mPatrolBounds.reserve(capacity);
+}
+
+void EntityStore::clear()
+{
+    positions.clear();
+    previousPositions.clear();
+    velocities.clear();
+    accelerations.clear();
+    colliderDimensions.clear();
+    sensorDimensions.clear();
+    platformSpeeds.clear();
+    patrolPaths.clear();
+    types.clear();
+    flags.clear();
+    mAlive.clear();
+    snapshotPositions.clear();
+    snapshotVelocities.clear();
+    mFreeHandles.clear();
+    mPatrolHandles.clear();
+    mPatrolBounds.clear();
+    mPatrolRoutes.clear();
+    mHasSnapshot = false;
+}
+
+/**
+ * Puts every active platform and enemy where its patrol path has it at
+ * `time`, and sets its velocity to the path's, so contacts with it see how
+ * fast it goes. This is the patrol system: one tight loop over the patrol
+ * list and nothing else, with no per-entity type checks. Nothing is
+ * integrated, so the result depends only on `time`, not on the steps
+ * before it.
+ * 
+ * @param time seconds of simulation since the level was spawned.
+ */
+void EntityStore::updatePatrols(double time)
+{
+    Rectangle everywhere = { -FLT_MAX, -FLT_MAX, INFINITY, INFINITY };
+    updatePatrols(time, everywhere, 0, getPatrolCount());
+}
+
+/**
+ * Patrol update for entries [`begin`, `end`) of the patrol list only (see
+ * `getPatrolCount()`), and only for patrols that can reach `area`. The rest
+ * keep their last position, which lies on their path or at their spawn
+ * point, so outside `area` too. Each entity's patrol depends on nothing but
+ * its own slots, so disjoint ranges can be updated on different threads at
+ * the same time.
+ *
+ * @param area where anything that looks at patrols this step can see them;
+ * a patrol is skipped when neither its collider nor its sensor can overlap
+ * it.
+ */
+void EntityStore::updatePatrols(double time, Rectangle area, int begin, 
+    int end)
+{
+    const EntityHandle *handles = mPatrolHandles.data();
+    const Rectangle    *bounds  = mPatrolBounds.data();
+
+    for (int k = begin; k < end; k++)
+    {
+        EntityHandle i = handles[k];
+
+        // Half the largest of the collider and sensor, on each axis
+        float reachX = fmaxf(colliderDimensions[i].x, sensorDimensions[i].x) * 
+            0.5f;
+        float reachY = fmaxf(colliderDimensions[i].y, sensorDimensions[i].y) * 
+            0.5f;
+        if (bounds[k].x - reachX > area.x + area.width ||
+            bounds[k].x + bounds[k].width + reachX < area.x ||
+            bounds[k].y - reachY > area.y + area.height ||
+            bounds[k].y + bounds[k].height + reachY < area.y)
+            continue;
+
+        // Inactive ones hold still, and rejoin their path where `time` has
+        // it once they are active again
+        unsigned char entityFlags = flags[i];
+        if ((entityFlags & FLAG_ACTIVE) == 0)
+        {
+            velocities[i] = { 0.0f, 0.0f };
+            continue;
+        }
+
+        positions[i] = mPatrolRoutes.evaluateAt(patrolPaths[i], 
+            platformSpeeds[i] * PLATFORM_SPEED_SCALE, time, &velocities[i]);
+
+        if (velocities[i].x > 0.0f)      entityFlags |=  FLAG_MOVING_RIGHT;
+        else if (velocities[i].x < 0.0f) entityFlags &= ~FLAG_MOVING_RIGHT;
+        flags[i] = entityFlags;
+    }
+}
+
+/**
+ * Freezes the current positions and velocities. Until `releaseSnapshot()`,
+ * collision code reads other entities' from the copies (see 
+ * `getCollisionPositions()`), so entities resolving their collisions in
+ * parallel all see the same world no matter which finishes first.
+ */
+void EntityStore::takeSnapshot()
+{
+    snapshotPositions.assign(positions.begin(), positions.end());
+    snapshotVelocities.assign(velocities.begin(), velocities.end());
+    mHasSnapshot = true;
+}
+
+/**
+ * Copies every array a step changes into `snapshot`, one `memcpy()` each.
+ *
+ * @return false if there are more entities than a snapshot holds; nothing
+ * is copied then.
+ */
+bool EntityStore::save(WorldSnapshot &snapshot) const
+{
+    int count = size();
+    if (count > WorldSnapshot::MAX_ENTITIES) return false;
+
+    snapshot.entityCount = count;
+    memcpy(snapshot.positions, positions.data(), count * sizeof(Vector2));
+    memcpy(snapshot.previousPositions, previousPositions.data(), 
+        count * sizeof(Vector2));
+    memcpy(snapshot.velocities, velocities.data(), count * sizeof(Vector2));
+    memcpy(snapshot.accelerations, accelerations.data(), 
+        count * sizeof(Vector2));
+    memcpy(snapshot.flags, flags.data(), count);
+    return true;
+}
+
+/**
+ * Puts back what `save()` copied. The store must hold the same entities it
+ * did then.
+ *
+ * @return false if the entity count differs; nothing is restored then.
+ */
+bool EntityStore::restore(const WorldSnapshot &snapshot)
+{
+    int count = size();
+    if (snapshot.entityCount != count) return false;
+
+    memcpy(positions.data(), snapshot.positions, count * sizeof(Vector2));
+    memcpy(previousPositions.data(), snapshot.previousPositions, 
+        count * sizeof(Vector2));
+    memcpy(velocities.data(), snapshot.velocities, count * sizeof(Vector2));
+    memcpy(accelerations.data(), snapshot.accelerations, 
+        count * sizeof(Vector2));
+    memcpy(flags.data(), snapshot.flags, count);
+    return true;
+}
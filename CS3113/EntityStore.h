@@ -0,0 +1,120 @@
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include "cs3113.h"
+#include "constants.h"
+#include "PatrolPath.h"
+#include "WorldSnapshot.h"
+
+enum Direction    { LEFT, UP, RIGHT, DOWN         }; 
+enum EntityStatus { ACTIVE, INACTIVE              };
+enum EntityType   { PLAYER, BLOCK, PLATFORM,ENEMY, NONE };
+
+typedef int EntityHandle;
+
+// Per-entity status bits packed into `EntityStore::flags`
+enum EntityFlag
+{
+    FLAG_ACTIVE           = 1 << 0,
+    FLAG_COLLIDING_TOP    = 1 << 1,
+    FLAG_COLLIDING_BOTTOM = 1 << 2,
+    FLAG_COLLIDING_RIGHT  = 1 << 3,
+    FLAG_COLLIDING_LEFT   = 1 << 4,
+    FLAG_MOVING_RIGHT     = 1 << 5,
+
+    FLAG_COLLIDING_ANY    = FLAG_COLLIDING_TOP | FLAG_COLLIDING_BOTTOM |
+                            FLAG_COLLIDING_RIGHT | FLAG_COLLIDING_LEFT
+};
+
+/**
+ * Structure-of-arrays storage for the data touched every simulation step.
+ * Each entity is a handle (an index) into parallel arrays, so the physics and
+ * collision loops stream through contiguous memory instead of chasing one
+ * heap-allocated `Entity` per object. Rarely-touched data such as textures and
+ * animation atlases stays on the `Entity` itself.
+ */
+class EntityStore
+{
+private:
+    bool mHasSnapshot = false;
+    // 1 from `create()` until `destroy()`. Kept apart from `types` and
+    // `flags`, which a live entity may legitimately clear
+    std::vector<unsigned char> mAlive;
+    // Handles given back by `destroy()`, reused by `create()`
+    std::vector<EntityHandle> mFreeHandles;
+    // Every platform and enemy, in no particular order: the patrol system's
+    // working set, so it never visits anything else
+    std::vector<EntityHandle> mPatrolHandles;
+    // Box around every position each entry of `mPatrolHandles` can be at
+    // (its route and where it spawned), in the same order
+    std::vector<Rectangle> mPatrolBounds;
+    // Waypoints for every entry in `patrolPaths`. Routes are only added, so
+    // replaced ones stay here until `clear()`
+    PatrolRoutes mPatrolRoutes;
+
+    static bool isPatrolType(unsigned char type) 
+        { return type == PLATFORM || type == ENEMY; }
+    void removePatrolHandle(EntityHandle handle);
+    void addPatrolHandle(EntityHandle handle);
+    Rectangle getPatrolBounds(EntityHandle handle) const;
+
+public:
+    std::vector<Vector2>       positions;
+    // Where each entity was when the step began, for interpolation; the
+    // game copies `positions` in at the top of every step
+    std::vector<Vector2>       previousPositions;
+    std::vector<Vector2>       velocities;
+    std::vector<Vector2>       accelerations;
+    std::vector<Vector2>       colliderDimensions;
+    // Trigger volumes, centred like the collider; zero for none
+    std::vector<Vector2>       sensorDimensions;
+    std::vector<float>         platformSpeeds;
+    // Where each platform and enemy patrols; empty for everything else
+    std::vector<PatrolPath>    patrolPaths;
+    std::vector<unsigned char> types;
+    std::vector<unsigned char> flags;
+
+    // Positions and velocities frozen by `takeSnapshot()` for collision
+    // queries
+    std::vector<Vector2>       snapshotPositions;
+    std::vector<Vector2>       snapshotVelocities;
+
+    static constexpr float DEFAULT_PLATFORM_SPEED = 2.0f;
+    // Platform speeds are tuned in pixels per 60 Hz frame
+    static constexpr float PLATFORM_SPEED_SCALE   = 60.0f;
+
+    EntityHandle create(Vector2 position, Vector2 colliderDimensions, 
+        EntityType entityType);
+    void destroy(EntityHandle handle);
+    void setType(EntityHandle handle, EntityType entityType);
+    void reserve(int capacity);
+    void clear();
+    int size() const { return (int) positions.size(); }
+    int getLiveCount() const { return size() - (int) mFreeHandles.size(); }
+    int getPatrolCount() const { return (int) mPatrolHandles.size(); }
+    bool isAlive(EntityHandle handle) const 
+        { return handle >= 0 && handle < size() && mAlive[handle] != 0; }
+
+    bool isActive(EntityHandle handle) const 
+        { return (flags[handle] & FLAG_ACTIVE) != 0; }
+
+    void setPatrolPath(EntityHandle handle, PatrolKind kind, 
+        const Vector2 *points, int count);
+    void updatePatrols(double time);
+    void updatePatrols(double time, Rectangle area, int begin, int end);
+
+    bool save(WorldSnapshot &snapshot) const;
+    bool restore(const WorldSnapshot &snapshot);
+
+    void takeSnapshot();
+    void releaseSnapshot() { mHasSnapshot = false; }
+
+    // Where collision code should read other entities' positions and
+    // velocities from
+    const Vector2 *getCollisionPositions() const 
+        { return mHasSnapshot ? snapshotPositions.data() : positions.data(); }
+    const Vector2 *getCollisionVelocities() const 
+        { return mHasSnapshot ? snapshotVelocities.data() : velocities.data(); }
+};
+
+#endif // ENTITY_STORE_H
@@ -0,0 +1,54 @@
+#include "FixedTimestep.h"
+
+FixedTimestep::FixedTimestep() : mStep {1.0f / DEFAULT_TICK_RATE}, 
+    mMaxCatchUpSteps {DEFAULT_MAX_CATCH_UP} { }
+
+FixedTimestep::FixedTimestep(float tickRate, int maxCatchUpSteps) : 
+    mStep {1.0f / DEFAULT_TICK_RATE}, mMaxCatchUpSteps {DEFAULT_MAX_CATCH_UP}
+{
+    setTickRate(tickRate);
+    setMaxCatchUpSteps(maxCatchUpSteps);
+}
+
+void FixedTimestep::setTickRate(float tickRate)
+{
+    if (tickRate <= 0.0f) tickRate = DEFAULT_TICK_RATE;
+    mStep = 1.0f / tickRate;
+}
+
+/**
+ * Adds the duration of the last rendered frame to the accumulator and returns
+ * how many fixed steps the caller should simulate before drawing.
+ * 
+ * Two guards keep a slow machine from falling into the "spiral of death",
+ * where each frame takes longer to simulate than the time it covers: a single
+ * frame never contributes more than `MAX_FRAME_TIME`, and at most
+ * `mMaxCatchUpSteps` steps are handed out per frame. Any backlog beyond that
+ * is dropped (and counted in `getDroppedSteps()`) rather than carried over.
+ * 
+ * @param frameTime seconds elapsed since the previous call.
+ * 
+ * @return the number of `getStep()`-sized steps to run this frame.
+ */
+int FixedTimestep::advance(float frameTime)
+{
+    if (frameTime < 0.0f)           frameTime = 0.0f;
+    if (frameTime > MAX_FRAME_TIME) frameTime = MAX_FRAME_TIME;
+
+    mAccumulator += frameTime;
+
+    int steps = 0;
+    while (mAccumulator >= mStep && steps < mMaxCatchUpSteps)
+    {
+        mAccumulator -= mStep;
+        steps++;
+    }
+
+    if (mAccumulator >= mStep)
+    {
+        mDroppedSteps += (int) (mAccumulator / mStep);
+        mAccumulator   = 0.0f;
+    }
+
+    return steps;
+}
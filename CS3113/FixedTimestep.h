@@ -0,0 +1,37 @@
+#ifndef FIXED_TIMESTEP_H
+#define FIXED_TIMESTEP_H
+
+/**
+ * Accumulator that turns variable render-frame durations into a whole number
+ * of fixed-size simulation steps, so physics behaves the same at any refresh
+ * rate. Leftover time is exposed as an interpolation factor for rendering.
+ */
+class FixedTimestep
+{
+private:
+    float mStep;
+    int   mMaxCatchUpSteps;
+    float mAccumulator   = 0.0f;
+    int   mDroppedSteps  = 0;
+
+public:
+    static constexpr float DEFAULT_TICK_RATE      = 120.0f;
+    static constexpr int   DEFAULT_MAX_CATCH_UP   = 8;
+    static constexpr float MAX_FRAME_TIME         = 0.25f;
+
+    FixedTimestep();
+    FixedTimestep(float tickRate, int maxCatchUpSteps);
+
+    int advance(float frameTime);
+    void reset() { mAccumulator = 0.0f; mDroppedSteps = 0; }
+
+    void setTickRate(float tickRate);
+    void setMaxCatchUpSteps(int steps) { mMaxCatchUpSteps = steps > 0 ? steps : 1; }
+
+    float getStep()         const { return mStep;                 }
+    float getTickRate()     const { return 1.0f / mStep;          }
+    float getAlpha()        const { return mAccumulator / mStep;  }
+    int   getDroppedSteps() const { return mDroppedSteps;         }
+};
+
+#endif // FIXED_TIMESTEP_H
@@ -0,0 +1,69 @@
+#ifndef HEADLESS_RAYLIB_H
+#define HEADLESS_RAYLIB_H
+
+/**
+ * The few raylib types and helpers the simulation uses, for HEADLESS builds,
+ * which must compile and run with no raylib installed. Layouts match
+ * raylib.h so the same code builds either way; nothing here draws.
+ */
+
+#include <math.h>
+
+typedef struct Vector2
+{
+    float x;
+    float y;
+} Vector2;
+
+typedef struct Rectangle
+{
+    float x;
+    float y;
+    float width;
+    float height;
+} Rectangle;
+
+typedef struct Color
+{
+    unsigned char r;
+    unsigned char g;
+    unsigned char b;
+    unsigned char a;
+} Color;
+
+typedef struct Image
+{
+    void *data;
+    int   width;
+    int   height;
+    int   mipmaps;
+    int   format;
+} Image;
+
+typedef struct Texture
+{
+    unsigned int id;
+    int          width;
+    int          height;
+    int          mipmaps;
+    int          format;
+} Texture;
+typedef Texture Texture2D;
+
+typedef struct RenderTexture
+{
+    unsigned int id;
+    Texture      texture;
+    Texture      depth;
+} RenderTexture;
+typedef RenderTexture RenderTexture2D;
+
+// As raylib's `PixelFormat`; baked textures only use this one
+enum { PIXELFORMAT_UNCOMPRESSED_R8G8B8A8 = 7 };
+
+#define WHITE    Color{ 255, 255, 255, 255 }
+#define BLACK    Color{ 0, 0, 0, 255 }
+#define BLANK    Color{ 0, 0, 0, 0 }
+#define RAYWHITE Color{ 245, 245, 245, 255 }
+
+#endif // HEADLESS_RAYLIB_H
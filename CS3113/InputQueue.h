@@ -0,0 +1,83 @@
+#ifndef INPUT_QUEUE_H
+#define INPUT_QUEUE_H
+
+#include <atomic>
+#include <chrono>
+
+/**
+ * One change in the player's input: the held keys from then on, plus any
+ * one-shot presses (`INPUT_JUMP`, `INPUT_QUIT`), stamped with when the
+ * change was seen.
+ */
+struct InputEvent
+{
+    std::chrono::steady_clock::time_point time;
+    unsigned char held;
+    unsigned char pressed;
+};
+
+/**
+ * Lock-free single-producer, single-consumer queue of `InputEvent`s, from
+ * the thread that polls the keyboard to the one that runs the simulation.
+ * Each side only writes its own index, so pushing and popping are a couple
+ * of atomic loads and stores and neither side ever blocks.
+ *
+ * The consumer looks at the oldest event with `peek()` first, so it can
+ * leave events that belong to a later step in the queue.
+ */
+class InputQueue
+{
+private:
+    // A power of two, so indices wrap with a mask
+    static constexpr unsigned int CAPACITY = 256;
+
+    InputEvent mEvents[CAPACITY];
+    std::atomic<unsigned int> mHead {0};   // next to pop, written by the consumer
+    std::atomic<unsigned int> mTail {0};   // next to push, written by the producer
+
+public:
+    InputQueue() { }
+
+    InputQueue(const InputQueue &) = delete;
+    InputQueue &operator=(const InputQueue &) = delete;
+
+    /**
+     * Producer only.
+     *
+     * @return false if the queue is full; the event was not added.
+     */
+    bool push(const InputEvent &event)
+    {
+        unsigned int tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) == CAPACITY)
+            return false;
+
+        mEvents[tail & (CAPACITY - 1)] = event;
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * Consumer only: copies the oldest event into `event` without removing
+     * it.
+     *
+     * @return false if the queue is empty.
+     */
+    bool peek(InputEvent *event) const
+    {
+        unsigned int head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire)) return false;
+
+        *event = mEvents[head & (CAPACITY - 1)];
+        return true;
+    }
+
+    // Consumer only: drops the event `peek()` returned
+    void pop()
+    {
+        mHead.store(mHead.load(std::memory_order_relaxed) + 1,
+            std::memory_order_release);
+    }
+};
+
+#endif // INPUT_QUEUE_H
@@ -0,0 +1,170 @@
+#include "InputRecording.h"
+#include <string.h>
+
+constexpr unsigned int   InputRecording::MAGIC;
+constexpr unsigned short InputRecording::VERSION;
+
+/**
+ * Appends the input applied on the next fixed step, extending the last run
+ * when it repeats.
+ */
+void InputRecording::record(unsigned char input)
+{
+    if (!mRuns.empty() && mRuns.back().input == input) mRuns.back().length++;
+    else mRuns.push_back({ input, 1 });
+
+    mStepCount++;
+}
+
+/**
+ * Reads the input for the next fixed step of a replay.
+ *
+ * @param input receives the step's `InputFlag` bitmask.
+ *
+ * @return false once every recorded step has been handed out.
+ */
+bool InputRecording::next(unsigned char *input)
+{
+    if (isFinished()) return false;
+
+    *input = mRuns[mRunIndex].input;
+
+    if (++mRunPosition >= mRuns[mRunIndex].length)
+    {
+        mRunIndex++;
+        mRunPosition = 0;
+    }
+
+    return true;
+}
+
+void InputRecording::clear()
+{
+    mRuns.clear();
+    mStepCount = 0;
+    rewind();
+}
+
+static void writeUnsigned(FILE *file, unsigned int value, int bytes)
+{
+    for (int i = 0; i < bytes; i++) fputc((value >> (8 * i)) & 0xFF, file);
+}
+
+static bool readUnsigned(FILE *file, unsigned int *value, int bytes)
+{
+    *value = 0;
+    for (int i = 0; i < bytes; i++)
+    {
+        int byte = fgetc(file);
+        if (byte == EOF) return false;
+        *value |= (unsigned int) byte << (8 * i);
+    }
+    return true;
+}
+
+static void writeVarint(FILE *file, unsigned int value)
+{
+    while (value >= 0x80)
+    {
+        fputc((value & 0x7F) | 0x80, file);
+        value >>= 7;
+    }
+    fputc(value, file);
+}
+
+static bool readVarint(FILE *file, unsigned int *value)
+{
+    *value = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        int byte = fgetc(file);
+        if (byte == EOF) return false;
+        *value |= (unsigned int) (byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+/**
+ * Writes the recording as a little-endian header (magic, version, seed, tick
+ * rate, step count, run count) followed by one delta byte and one varint
+ * length per run.
+ *
+ * @return false if the file could not be written.
+ */
+bool InputRecording::save(const char *filepath) const
+{
+    FILE *file = fopen(filepath, "wb");
+    if (!file) return false;
+
+    unsigned int tickRateBits;
+    memcpy(&tickRateBits, &mTickRate, sizeof(tickRateBits));
+
+    writeUnsigned(file, MAGIC, 4);
+    writeUnsigned(file, VERSION, 2);
+    writeUnsigned(file, mSeed, 4);
+    writeUnsigned(file, tickRateBits, 4);
+    writeUnsigned(file, (unsigned int) mStepCount, 4);
+    writeUnsigned(file, (unsigned int) mRuns.size(), 4);
+
+    unsigned char previous = 0;
+    for (const Run &run : mRuns)
+    {
+        fputc(run.input ^ previous, file);
+        writeVarint(file, run.length);
+        previous = run.input;
+    }
+
+    bool ok = !ferror(file);
+    return fclose(file) == 0 && ok;
+}
+
+/**
+ * Replaces this recording with the one stored at `filepath` and rewinds the
+ * replay cursor.
+ *
+ * @return false if the file is missing, truncated, from a different version,
+ * or its runs don't add up to the step count in its header. The recording
+ * is left empty in that case.
+ */
+bool InputRecording::load(const char *filepath)
+{
+    clear();
+
+    FILE *file = fopen(filepath, "rb");
+    if (!file) return false;
+
+    unsigned int magic, version, seed, tickRateBits, stepCount, runCount;
+    bool ok = readUnsigned(file, &magic, 4) && magic == MAGIC &&
+              readUnsigned(file, &version, 2) && version == VERSION &&
+              readUnsigned(file, &seed, 4) &&
+              readUnsigned(file, &tickRateBits, 4) &&
+              readUnsigned(file, &stepCount, 4) &&
+              readUnsigned(file, &runCount, 4);
+
+    unsigned char previous = 0;
+    unsigned int  total    = 0;
+    for (unsigned int i = 0; ok && i < runCount; i++)
+    {
+        int delta = fgetc(file);
+        unsigned int length;
+        ok = delta != EOF && readVarint(file, &length) && length > 0;
+        if (!ok) break;
+
+        previous ^= (unsigned char) delta;
+        mRuns.push_back({ previous, length });
+        total += length;
+    }
+    fclose(file);
+
+    if (!ok || total != stepCount)
+    {
+        clear();
+        return false;
+    }
+
+    mSeed      = seed;
+    mStepCount = (int) stepCount;
+    memcpy(&mTickRate, &tickRateBits, sizeof(mTickRate));
+    return true;
+}
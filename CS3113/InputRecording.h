@@ -0,0 +1,56 @@
+#ifndef INPUT_RECORDING_H
+#define INPUT_RECORDING_H
+
+#include "cs3113.h"
+
+/**
+ * Everything needed to reproduce a run: the RNG seed the level was built
+ * from, the physics tick rate, and the `InputFlag` bitmask applied on every
+ * fixed step. Inputs are kept as runs of identical steps, so a recording
+ * costs a few bytes per key change rather than one byte per step.
+ *
+ * On disk each run is stored as the XOR of its input with the previous run's
+ * input followed by its length as a varint.
+ */
+class InputRecording
+{
+private:
+    struct Run
+    {
+        unsigned char input;
+        unsigned int  length;
+    };
+
+    unsigned int     mSeed     = 0;
+    float            mTickRate = 0.0f;
+    std::vector<Run> mRuns;
+    int              mStepCount = 0;
+
+    // Replay cursor
+    int          mRunIndex    = 0;
+    unsigned int mRunPosition = 0;
+
+public:
+    static constexpr unsigned int   MAGIC   = 0x49333143; // "C13I"
+    static constexpr unsigned short VERSION = 1;
+
+    InputRecording() { }
+    InputRecording(unsigned int seed, float tickRate) : mSeed {seed},
+        mTickRate {tickRate} { }
+
+    void record(unsigned char input);
+    bool next(unsigned char *input);
+    void rewind() { mRunIndex = 0; mRunPosition = 0; }
+    void clear();
+
+    bool save(const char *filepath) const;
+    bool load(const char *filepath);
+
+    unsigned int getSeed()      const { return mSeed;                     }
+    float        getTickRate()  const { return mTickRate;                 }
+    int          getStepCount() const { return mStepCount;                }
+    int          getRunCount()  const { return (int) mRuns.size();        }
+    bool         isFinished()   const { return mRunIndex >= (int) mRuns.size(); }
+};
+
+#endif // INPUT_RECORDING_H
@@ -0,0 +1,155 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+constexpr int JobSystem::DEFAULT_GRAIN_SIZE;
+
+/**
+ * @param workerCount number of background threads to start in addition to
+ * the calling thread. Negative picks `getDefaultWorkerCount()`; zero runs
+ * every loop inline.
+ */
+JobSystem::JobSystem(int workerCount)
+{
+    startWorkers(workerCount);
+}
+
+JobSystem::~JobSystem() { stopWorkers(); }
+
+/**
+ * One worker per hardware thread, minus the one the caller runs on.
+ */
+int JobSystem::getDefaultWorkerCount()
+{
+    int hardwareThreads = (int) std::thread::hardware_concurrency();
+    return hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+}
+
+void JobSystem::setWorkerCount(int workerCount)
+{
+    stopWorkers();
+    startWorkers(workerCount);
+}
+
+void JobSystem::startWorkers(int workerCount)
+{
+    if (workerCount < 0) workerCount = getDefaultWorkerCount();
+
+    mIsStopping = false;
+    mQueues.clear();
+    for (int i = 0; i <= workerCount; i++)
+        mQueues.push_back(std::unique_ptr<Queue>(new Queue));
+
+    for (int i = 1; i <= workerCount; i++)
+        mThreads.push_back(std::thread(&JobSystem::workerLoop, this, i));
+}
+
+void JobSystem::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mIsStopping = true;
+    }
+    mWake.notify_all();
+
+    for (std::thread &thread : mThreads) thread.join();
+    mThreads.clear();
+}
+
+/**
+ * Runs one task: the newest from the thread's own queue if it has any,
+ * otherwise the oldest from the first other queue that does.
+ *
+ * @return false if every queue was empty.
+ */
+bool JobSystem::runTask(int queueIndex)
+{
+    Task task;
+    bool found     = false;
+    int queueCount = (int) mQueues.size();
+
+    for (int offset = 0; offset < queueCount && !found; offset++)
+    {
+        Queue &queue = *mQueues[(queueIndex + offset) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.head == queue.tasks.size()) continue;
+
+        if (offset == 0)
+        {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        }
+        else task = queue.tasks[queue.head++];
+
+        if (queue.head == queue.tasks.size())
+        {
+            queue.tasks.clear();
+            queue.head = 0;
+        }
+        found = true;
+    }
+
+    if (!found) return false;
+
+    (*task.job)(task.begin, task.end);
+    mPendingTasks.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+void JobSystem::workerLoop(int queueIndex)
+{
+    unsigned int seenGeneration = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mWakeMutex);
+            mWake.wait(lock, [&] {
+                return mIsStopping || mGeneration != seenGeneration;
+            });
+            if (mIsStopping) return;
+            seenGeneration = mGeneration;
+        }
+
+        while (runTask(queueIndex)) { }
+    }
+}
+
+/**
+ * Calls `job` over [0, `count`) in chunks of at most `grainSize` items,
+ * spread across every thread, and returns once all of them have finished.
+ * Chunks may run in any order and on any thread, so `job` must only write
+ * to data owned by its own chunk.
+ */
+void JobSystem::parallelFor(int count, int grainSize, const RangeJob &job)
+{
+    if (count <= 0) return;
+    if (grainSize < 1) grainSize = 1;
+
+    if (mThreads.empty() || count <= grainSize)
+    {
+        job(0, count);
+        return;
+    }
+
+    int taskCount  = (count + grainSize - 1) / grainSize;
+    int queueCount = (int) mQueues.size();
+    mPendingTasks.store(taskCount, std::memory_order_release);
+
+    for (int t = 0; t < taskCount; t++)
+    {
+        Task task = { &job, t * grainSize, std::min(count, (t + 1) * grainSize) };
+        Queue &queue = *mQueues[t % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(task);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mWakeMutex);
+        mGeneration++;
+    }
+    mWake.notify_all();
+
+    // The caller works too, then waits for chunks still running elsewhere
+    while (mPendingTasks.load(std::memory_order_acquire) > 0)
+        if (!runTask(0)) std::this_thread::yield();
+}
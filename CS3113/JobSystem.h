@@ -0,0 +1,98 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include "cs3113.h"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/**
+ * Small work-stealing thread pool for data-parallel loops. `parallelFor()`
+ * cuts a range into chunks and deals them round-robin onto one queue per
+ * thread (the calling thread included). Each thread drains its own queue from
+ * the back and, once it runs dry, steals from the front of the others', so
+ * uneven chunks still keep every core busy.
+ *
+ * Jobs must not call `parallelFor()` themselves.
+ */
+class JobSystem
+{
+public:
+    /**
+     * Body of a parallel loop, called with a half-open chunk [begin, end).
+     * Only refers to the callable (usually a lambda) rather than copying it
+     * like `std::function` would, so passing one never allocates; the
+     * callable just has to outlive the `parallelFor()` call.
+     */
+    class RangeJob
+    {
+    private:
+        const void *mCallable;
+        void (*mInvoke)(const void *callable, int begin, int end);
+
+        template <typename Callable>
+        static void invoke(const void *callable, int begin, int end)
+            { (*(const Callable *) callable)(begin, end); }
+
+    public:
+        template <typename Callable>
+        RangeJob(const Callable &callable) : mCallable {&callable}, 
+            mInvoke {&invoke<Callable>} { }
+
+        void operator()(int begin, int end) const 
+            { mInvoke(mCallable, begin, end); }
+    };
+
+private:
+    struct Task
+    {
+        const RangeJob *job;
+        int begin;
+        int end;
+    };
+
+    // Tasks [head, tasks.size()) are waiting. The vector only empties once
+    // both ends meet, so its capacity is reused and queueing never allocates
+    // after the first few loops
+    struct Queue
+    {
+        std::mutex        mutex;
+        std::vector<Task> tasks;
+        size_t            head = 0;
+    };
+
+    std::vector<std::thread>            mThreads;
+    std::vector<std::unique_ptr<Queue>> mQueues;   // [0] belongs to the caller
+
+    std::atomic<int>        mPendingTasks {0};
+    std::mutex              mWakeMutex;
+    std::condition_variable mWake;
+    unsigned int            mGeneration = 0;
+    bool                    mIsStopping = false;
+
+    bool runTask(int queueIndex);
+    void workerLoop(int queueIndex);
+    void startWorkers(int workerCount);
+    void stopWorkers();
+
+public:
+    static constexpr int DEFAULT_GRAIN_SIZE = 256;
+
+    explicit JobSystem(int workerCount = -1);
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    void setWorkerCount(int workerCount);
+    void parallelFor(int count, int grainSize, const RangeJob &job);
+
+    int getWorkerCount() const { return (int) mThreads.size();     }
+    int getThreadCount() const { return (int) mThreads.size() + 1; }
+
+    static int getDefaultWorkerCount();
+};
+
+#endif // JOB_SYSTEM_H
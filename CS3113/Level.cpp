@@ -0,0 +1,265 @@
+#include "Level.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LEVEL_USE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// The file format stores these enums as raw numbers
+static_assert(LEFT == 0 && UP == 1 && RIGHT == 2 && DOWN == 3,
+    "Direction order is part of the level format");
+static_assert(PLAYER == 0 && BLOCK == 1 && PLATFORM == 2 && ENEMY == 3 &&
+    NONE == 4, "EntityType values are part of the level format");
+static_assert(PATROL_PING_PONG == 0 && PATROL_LOOP == 1 && PATROL_SPLINE == 2,
+    "PatrolKind values are part of the level format");
+
+/**
+ * Maps the level at `filepath` and checks it is well formed.
+ *
+ * @return false if the file is missing, isn't a level of this version, or
+ * has any offset or index pointing outside the file; nothing stays open in
+ * that case.
+ */
+bool Level::open(const char *filepath)
+{
+    close();
+
+#if defined(LEVEL_USE_MMAP)
+    int descriptor = ::open(filepath, O_RDONLY);
+    if (descriptor < 0) return false;
+
+    struct stat status;
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+    {
+        void *mapping = mmap(nullptr, (size_t) status.st_size, PROT_READ,
+            MAP_PRIVATE, descriptor, 0);
+
+        if (mapping != MAP_FAILED)
+        {
+            mData     = (const unsigned char *) mapping;
+            mSize     = (size_t) status.st_size;
+            mIsMapped = true;
+        }
+    }
+    ::close(descriptor);
+#else
+    FILE *file = fopen(filepath, "rb");
+    if (!file) return false;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    if (size > 0)
+    {
+        unsigned char *buffer = (unsigned char *) malloc((size_t) size);
+        if (buffer && fread(buffer, 1, (size_t) size, file) == (size_t) size)
+        {
+            mData = buffer;
+            mSize = (size_t) size;
+        }
+        else free(buffer);
+    }
+    fclose(file);
+#endif
+
+    if (!mData || mSize < sizeof(LevelHeader))
+    {
+        close();
+        return false;
+    }
+
+    mHeader   = (const LevelHeader *) mData;
+    mEntities = (const LevelEntity *) (mData + mHeader->entityOffset);
+    mClips    = (const LevelClip *)   (mData + mHeader->clipOffset);
+    mFrames   = (const uint16_t *)    (mData + mHeader->frameOffset);
+    mStrings  = (const char *)        (mData + mHeader->stringOffset);
+    mPoints   = (const float *)       (mData + mHeader->pointOffset);
+
+    if (!validate())
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void Level::close()
+{
+#if defined(LEVEL_USE_MMAP)
+    if (mData && mIsMapped) munmap((void *) mData, mSize);
+#endif
+    if (mData && !mIsMapped) free((void *) mData);
+
+    mData     = nullptr;
+    mSize     = 0;
+    mIsMapped = false;
+    mHeader   = nullptr;
+    mEntities = nullptr;
+    mClips    = nullptr;
+    mFrames   = nullptr;
+    mStrings  = nullptr;
+    mPoints   = nullptr;
+}
+
+/**
+ * True if section [`offset`, `offset` + `count` * `stride`) lies inside a
+ * file of `size` bytes and starts 4-byte aligned.
+ */
+static bool sectionFits(uint32_t offset, uint32_t count, size_t stride,
+    size_t size)
+{
+    if (offset % 4 != 0 || offset > size) return false;
+    return (uint64_t) count * stride <= size - offset;
+}
+
+bool Level::validate() const
+{
+    const LevelHeader &header = *mHeader;
+
+    if (header.magic != LEVEL_MAGIC || header.version != LEVEL_VERSION ||
+        header.headerSize != sizeof(LevelHeader)) return false;
+
+    if (!sectionFits(header.entityOffset, header.entityCount,
+            sizeof(LevelEntity), mSize) ||
+        !sectionFits(header.clipOffset, header.clipCount,
+            sizeof(LevelClip), mSize) ||
+        !sectionFits(header.frameOffset, header.frameCount,
+            sizeof(uint16_t), mSize) ||
+        !sectionFits(header.stringOffset, header.stringBytes, 1, mSize) ||
+        !sectionFits(header.pointOffset, header.pointCount,
+            2 * sizeof(float), mSize))
+        return false;
+
+    // Every string must end inside the table
+    if (header.stringBytes == 0 || mStrings[header.stringBytes - 1] != '\0')
+        return false;
+
+    for (uint32_t i = 0; i < header.entityCount; i++)
+    {
+        const LevelEntity &entity = mEntities[i];
+
+        if (entity.textureOffset >= header.stringBytes) return false;
+        if (entity.type > NONE) return false;
+        if (entity.clipIndex >= (int) header.clipCount) return false;
+        if (entity.clipIndex >= 0 &&
+            (entity.sheetDimensions[0] == 0 || entity.sheetDimensions[1] == 0))
+            return false;
+        if (entity.pathKind > PATROL_SPLINE) return false;
+        if ((uint32_t) entity.firstPoint + entity.pointCount > header.pointCount)
+            return false;
+    }
+
+    for (uint32_t i = 0; i < header.clipCount; i++)
+    {
+        for (int d = 0; d < LEVEL_DIRECTIONS; d++)
+        {
+            // Animation indexes every direction's frames, so none may be
+            // empty
+            if (mClips[i].frameCount[d] == 0) return false;
+
+            uint32_t end = (uint32_t) mClips[i].firstFrame[d] +
+                mClips[i].frameCount[d];
+            if (end > header.frameCount) return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * Creates one entity per record in `pool`, in file order, and appends them
+ * to `entities`; they live until the pool despawns them. Spawn positions
+ * with a range draw from `RandomInt()`, x before y, so a seed reproduces a
+ * layout.
+ *
+ * @return the number of entities created, fewer than `getEntityCount()` only
+ * if the pool ran out of room.
+ */
+int Level::spawn(EntityStore *store, Pool<Entity> &pool, 
+    std::vector<Entity *> &entities) const
+{
+    if (!isOpen()) return 0;
+
+    for (uint32_t i = 0; i < mHeader->entityCount; i++)
+    {
+        const LevelEntity &record = mEntities[i];
+
+        Vector2 position;
+        position.x = record.spawnMin[0] == record.spawnMax[0] ? record.spawnMin[0] :
+            (float) RandomInt((int) record.spawnMin[0], (int) record.spawnMax[0]);
+        position.y = record.spawnMin[1] == record.spawnMax[1] ? record.spawnMin[1] :
+            (float) RandomInt((int) record.spawnMin[1], (int) record.spawnMax[1]);
+
+        Vector2 scale = { record.scale[0], record.scale[1] };
+        const char *texture = getString(record.textureOffset);
+        EntityType type = (EntityType) record.type;
+
+        PoolHandle handle;
+        if (record.clipIndex >= 0)
+        {
+            const LevelClip &clip = mClips[record.clipIndex];
+
+            std::map<Direction, std::vector<int>> animationAtlas;
+            for (int d = 0; d < LEVEL_DIRECTIONS; d++)
+            {
+                const uint16_t *frames = mFrames + clip.firstFrame[d];
+                animationAtlas[(Direction) d].assign(frames,
+                    frames + clip.frameCount[d]);
+            }
+
+            Vector2 sheetDimensions = { (float) record.sheetDimensions[0],
+                                        (float) record.sheetDimensions[1] };
+            handle = pool.spawn(store, position, scale, texture, ATLAS,
+                sheetDimensions, animationAtlas, type);
+        }
+        else handle = pool.spawn(store, position, scale, texture, type);
+
+        Entity *entity = pool.get(handle);
+        if (!entity) return (int) i;
+
+        entity->setPlatformSpeed(record.patrolSpeed);
+        if (record.pointCount > 0)
+        {
+            std::vector<Vector2> points(record.pointCount);
+            for (int p = 0; p < record.pointCount; p++)
+                points[p] = getPoint(record.firstPoint + p);
+            entity->setPatrolPath((PatrolKind) record.pathKind, points.data(),
+                record.pointCount);
+        }
+        entity->setRenderLayer(record.renderLayer);
+        if (record.bounciness >= 0.0f) entity->setBounciness(record.bounciness);
+        if (record.sensor[0] > 0.0f)
+            entity->setSensorDimensions({ record.sensor[0], record.sensor[1] });
+        if (record.frameSpeed > 0)     entity->setFrameSpeed(record.frameSpeed);
+
+        entities.push_back(entity);
+    }
+
+    return (int) mHeader->entityCount;
+}
+
+/**
+ * Lists each texture the level uses once, in order of first use.
+ */
+void Level::getTextureFilepaths(std::vector<const char *> &filepaths) const
+{
+    if (!isOpen()) return;
+
+    for (uint32_t i = 0; i < mHeader->entityCount; i++)
+    {
+        const char *texture = getString(mEntities[i].textureOffset);
+
+        bool seen = false;
+        for (const char *filepath : filepaths)
+            if (strcmp(filepath, texture) == 0) seen = true;
+
+        if (!seen) filepaths.push_back(texture);
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include "Entity.h"
+#include "LevelFormat.h"
+#include "Pool.h"
+
+/**
+ * A compiled level file (see LevelFormat.h), memory-mapped read-only. After
+ * `open()` has checked that every offset and index stays inside the file,
+ * the records are read straight out of the mapping; `spawn()` turns them
+ * into pooled entities in an `EntityStore`.
+ *
+ * Where memory mapping isn't available the file is read into memory with a
+ * single read instead.
+ */
+class Level
+{
+private:
+    const unsigned char *mData = nullptr;
+    size_t mSize     = 0;
+    bool   mIsMapped = false;
+
+    const LevelHeader *mHeader   = nullptr;
+    const LevelEntity *mEntities = nullptr;
+    const LevelClip   *mClips    = nullptr;
+    const uint16_t    *mFrames   = nullptr;
+    const char        *mStrings  = nullptr;
+    const float       *mPoints   = nullptr;   // x, y pairs
+
+    bool validate() const;
+
+public:
+    Level() { }
+    ~Level() { close(); }
+
+    Level(const Level &) = delete;
+    Level &operator=(const Level &) = delete;
+
+    bool open(const char *filepath);
+    void close();
+    bool isOpen() const { return mHeader != nullptr; }
+
+    int spawn(EntityStore *store, Pool<Entity> &pool, 
+        std::vector<Entity *> &entities) const;
+    void getTextureFilepaths(std::vector<const char *> &filepaths) const;
+
+    int getEntityCount() const { return mHeader ? (int) mHeader->entityCount : 0; }
+    const LevelEntity &getEntity(int index) const { return mEntities[index]; }
+    const char *getString(uint32_t offset) const { return mStrings + offset; }
+    // Waypoint `index` of the table, as an offset from the spawn point
+    Vector2 getPoint(int index) const
+        { return { mPoints[2 * index], mPoints[2 * index + 1] }; }
+};
+
+#endif // LEVEL_H
@@ -0,0 +1,75 @@
+#ifndef LEVEL_FORMAT_H
+#define LEVEL_FORMAT_H
+
+#include <stdint.h>
+
+/**
+ * On-disk layout of a compiled level (.lvl). Every record is plain data at a
+ * 4-byte-aligned offset, so a mapped file is used in place with no parsing.
+ * Values are stored in the byte order of the machine that compiled them
+ * (little-endian on every platform we ship).
+ *
+ *   LevelHeader
+ *   LevelEntity[entityCount]   at entityOffset
+ *   LevelClip[clipCount]       at clipOffset
+ *   uint16_t[frameCount]       at frameOffset, sprite-sheet frame indices
+ *   float[pointCount][2]       at pointOffset, patrol waypoints
+ *   char[stringBytes]          at stringOffset, NUL-terminated strings
+ *
+ * This header is shared with tools/level_converter.cpp, which builds .lvl
+ * files from the text form in levels/, so it must not depend on raylib.
+ */
+
+static const uint32_t LEVEL_MAGIC   = 0x4C333143; // "C13L"
+static const uint16_t LEVEL_VERSION = 3;
+
+// Number of animation directions, in `Direction` order: LEFT, UP, RIGHT, DOWN
+static const int LEVEL_DIRECTIONS = 4;
+
+struct LevelHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;
+    uint32_t entityCount;
+    uint32_t entityOffset;
+    uint32_t clipCount;
+    uint32_t clipOffset;
+    uint32_t frameCount;
+    uint32_t frameOffset;
+    uint32_t stringBytes;
+    uint32_t stringOffset;
+    uint32_t pointCount;
+    uint32_t pointOffset;
+};
+
+struct LevelEntity
+{
+    float    spawnMin[2];       // spawn position is random per axis in
+    float    spawnMax[2];       // [min, max], or fixed where they're equal
+    float    scale[2];
+    float    patrolSpeed;
+    float    bounciness;        // negative keeps the entity default
+    float    sensor[2];         // trigger volume size, zero for none
+    uint32_t textureOffset;     // into the string table
+    int16_t  clipIndex;         // -1 for single-image entities
+    uint8_t  type;              // `EntityType`
+    uint8_t  renderLayer;
+    uint8_t  sheetDimensions[2];// as `Entity`'s sprite-sheet dimensions
+    uint8_t  frameSpeed;        // 0 keeps the entity default
+    uint8_t  pathKind;          // as `PatrolKind`
+    uint16_t firstPoint;        // into the waypoint table, relative to the
+    uint16_t pointCount;        // spawn point; none for the default patrol
+};
+
+struct LevelClip
+{
+    uint16_t firstFrame[LEVEL_DIRECTIONS]; // into the frame index table
+    uint16_t frameCount[LEVEL_DIRECTIONS];
+};
+
+static_assert(sizeof(LevelHeader) == 48, "LevelHeader layout changed");
+static_assert(sizeof(LevelEntity) == 56, "LevelEntity layout changed");
+static_assert(sizeof(LevelClip)   == 16, "LevelClip layout changed");
+
+#endif // LEVEL_FORMAT_H
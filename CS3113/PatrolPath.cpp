@@ -0,0 +1,202 @@
+#include "PatrolPath.h"
+#include "constants.h"
+
+/**
+ * Adds a route through `count` waypoints and measures it.
+ *
+ * @return a path along it, placed at the origin and starting at the first
+ * waypoint; set `origin` and `phase` to place it.
+ */
+PatrolPath PatrolRoutes::add(PatrolKind kind, const Vector2 *points, int count)
+{
+    if (count > 0xFFFF) count = 0xFFFF;
+
+    PatrolPath path;
+    path.origin     = { 0.0f, 0.0f };
+    path.phase      = 0.0f;
+    path.length     = 0.0f;
+    path.firstPoint = (int) mPoints.size();
+    path.pointCount = (unsigned short) (count > 0 ? count : 0);
+    path.kind       = (unsigned char) kind;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (i > 0)
+        {
+            path.length += GetLength({ points[i].x - points[i - 1].x,
+                                       points[i].y - points[i - 1].y });
+        }
+        mPoints.push_back(points[i]);
+        mDistances.push_back(path.length);
+    }
+
+    // Loops and splines close back onto their first waypoint
+    if (kind != PATROL_PING_PONG && count > 1)
+    {
+        path.length += GetLength({ points[0].x - points[count - 1].x,
+                                   points[0].y - points[count - 1].y });
+    }
+
+    return path;
+}
+
+/**
+ * Adds the default patrol: back and forth across the whole screen, turning
+ * where an entity `halfWidth` wide touches either edge. To place it, set
+ * `origin.y` to the height to patrol at and `phase` to how far right of the
+ * left turning point to start.
+ */
+PatrolPath PatrolRoutes::addEdgeToEdge(float halfWidth)
+{
+    Vector2 points[] = { { halfWidth, 0.0f },
+                         { SCREEN_WIDTH - halfWidth, 0.0f } };
+    return add(PATROL_PING_PONG, points, 2);
+}
+
+void PatrolRoutes::clear()
+{
+    mPoints.clear();
+    mDistances.clear();
+}
+
+/**
+ * Where `path` puts an entity that has travelled `distance` along it (its
+ * phase included). Spline segments are timed by the straight distance
+ * between their waypoints, so speed on a curve is only roughly constant.
+ *
+ * @param direction receives the change in position per unit of distance,
+ * i.e. the velocity at a speed of one.
+ */
+Vector2 PatrolRoutes::evaluate(const PatrolPath &path, double distance,
+    Vector2 *direction) const
+{
+    *direction = { 0.0f, 0.0f };
+    int count = path.pointCount;
+    if (count == 0) return path.origin;
+
+    const Vector2 *points    = &mPoints[path.firstPoint];
+    const float   *distances = &mDistances[path.firstPoint];
+    if (count == 1 || path.length <= 0.0f)
+        return { path.origin.x + points[0].x, path.origin.y + points[0].y };
+
+    // Wrap in double precision so long-running patrols don't drift
+    bool   isPingPong = path.kind == PATROL_PING_PONG;
+    double period     = isPingPong ? 2.0 * path.length : (double) path.length;
+    double wrapped    = fmod(distance, period);
+    if (wrapped < 0.0) wrapped += period;
+
+    bool isReturning = isPingPong && wrapped > path.length;
+    if (isReturning) wrapped = period - wrapped;
+    float along = (float) wrapped;
+
+    // The last waypoint at or before `along`; a ping-pong route has no
+    // segment after its last waypoint
+    int low  = 0;
+    int high = isPingPong ? count - 2 : count - 1;
+    while (low < high)
+    {
+        int middle = (low + high + 1) / 2;
+        if (distances[middle] <= along) low = middle;
+        else high = middle - 1;
+    }
+
+    int     i   = low;
+    Vector2 a   = points[i];
+    Vector2 b   = points[(i + 1) % count];
+    float   end = i + 1 < count ? distances[i + 1] : path.length;
+    float   segmentLength = end - distances[i];
+    if (segmentLength <= 0.0f)
+        return { path.origin.x + a.x, path.origin.y + a.y };
+
+    float t = (along - distances[i]) / segmentLength;
+    if (t < 0.0f) t = 0.0f;
+    if (t > 1.0f) t = 1.0f;
+
+    Vector2 position, tangent;
+    if (path.kind == PATROL_SPLINE)
+    {
+        // Uniform Catmull-Rom through a and b, shaped by their neighbours
+        Vector2 before = points[(i + count - 1) % count];
+        Vector2 after  = points[(i + 2) % count];
+        float t2 = t * t;
+
+        Vector2 c1 = { b.x - before.x, b.y - before.y };
+        Vector2 c2 = { 2.0f * before.x - 5.0f * a.x + 4.0f * b.x - after.x,
+                       2.0f * before.y - 5.0f * a.y + 4.0f * b.y - after.y };
+        Vector2 c3 = { -before.x + 3.0f * a.x - 3.0f * b.x + after.x,
+                       -before.y + 3.0f * a.y - 3.0f * b.y + after.y };
+
+        position = { a.x + 0.5f * (c1.x * t + c2.x * t2 + c3.x * t2 * t),
+                     a.y + 0.5f * (c1.y * t + c2.y * t2 + c3.y * t2 * t) };
+        tangent  = { 0.5f * (c1.x + 2.0f * c2.x * t + 3.0f * c3.x * t2),
+                     0.5f * (c1.y + 2.0f * c2.y * t + 3.0f * c3.y * t2) };
+    }
+    else
+    {
+        position = { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t };
+        tangent  = { b.x - a.x, b.y - a.y };
+    }
+
+    float scale = (isReturning ? -1.0f : 1.0f) / segmentLength;
+    *direction = { tangent.x * scale, tangent.y * scale };
+    return { path.origin.x + position.x, path.origin.y + position.y };
+}
+
+/**
+ * Where `path` puts an entity that has patrolled it at `speed` for `time`
+ * seconds, starting from its phase.
+ *
+ * @param velocity receives the entity's velocity there.
+ */
+Vector2 PatrolRoutes::evaluateAt(const PatrolPath &path, float speed, 
+    double time, Vector2 *velocity) const
+{
+    Vector2 direction;
+    Vector2 position = evaluate(path, path.phase + (double) speed * time, 
+        &direction);
+
+    *velocity = { direction.x * speed, direction.y * speed };
+    return position;
+}
+
+/**
+ * The smallest box holding every position `evaluate()` can give for `path`.
+ * A spline segment stays inside the box around its Bezier control points.
+ * The box is grown by a pixel to cover rounding in `evaluate()`.
+ */
+Rectangle PatrolRoutes::getBounds(const PatrolPath &path) const
+{
+    int count = path.pointCount;
+    if (count == 0) return { path.origin.x, path.origin.y, 0.0f, 0.0f };
+
+    const Vector2 *points = &mPoints[path.firstPoint];
+    Vector2 low  = points[0];
+    Vector2 high = points[0];
+
+    for (int i = 0; i < count; i++)
+    {
+        Vector2 corners[3] = { points[i], points[i], points[i] };
+        if (path.kind == PATROL_SPLINE && count > 1)
+        {
+            Vector2 before = points[(i + count - 1) % count];
+            Vector2 a      = points[i];
+            Vector2 b      = points[(i + 1) % count];
+            Vector2 after  = points[(i + 2) % count];
+
+            corners[1] = { a.x + (b.x - before.x) / 6.0f,
+                           a.y + (b.y - before.y) / 6.0f };
+            corners[2] = { b.x - (after.x - a.x) / 6.0f,
+                           b.y - (after.y - a.y) / 6.0f };
+        }
+
+        for (const Vector2 &corner : corners)
+        {
+            low  = { fminf(low.x, corner.x),  fminf(low.y, corner.y)  };
+            high = { fmaxf(high.x, corner.x), fmaxf(high.y, corner.y) };
+        }
+    }
+
+    constexpr float margin = 1.0f;
+    return { path.origin.x + low.x - margin, path.origin.y + low.y - margin,
+             high.x - low.x + 2.0f * margin, high.y - low.y + 2.0f * margin };
+}
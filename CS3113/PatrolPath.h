@@ -0,0 +1,55 @@
+#ifndef PATROL_PATH_H
+#define PATROL_PATH_H
+
+#include "cs3113.h"
+
+// How a patrol follows its waypoints. Stored as raw numbers in level files
+enum PatrolKind
+{
+    PATROL_PING_PONG,   // along the waypoints and back again
+    PATROL_LOOP,        // around them in straight lines, last back to first
+    PATROL_SPLINE       // around them on a closed Catmull-Rom curve
+};
+
+/**
+ * Where one entity patrols: a route in a `PatrolRoutes` table, placed at
+ * `origin`. Where it is depends only on how far it has travelled, so its
+ * position at any time is computed directly, with no stepping through the
+ * time before, and fast-forwarding or rewinding costs the same as one step.
+ */
+struct PatrolPath
+{
+    Vector2        origin;       // added to every waypoint
+    float          phase;        // distance along the route at time zero
+    float          length;       // one way for ping-pong, one lap otherwise
+    int            firstPoint;   // into the table's waypoints
+    unsigned short pointCount;
+    unsigned char  kind;
+};
+
+/**
+ * Waypoints for any number of `PatrolPath`s, with each one's distance along
+ * its route measured once when it is added, so evaluating a path is a
+ * search over its waypoints and a little arithmetic.
+ */
+class PatrolRoutes
+{
+private:
+    std::vector<Vector2> mPoints;
+    // Distance along the route from its first waypoint to each one
+    std::vector<float>   mDistances;
+
+public:
+    PatrolPath add(PatrolKind kind, const Vector2 *points, int count);
+    PatrolPath addEdgeToEdge(float halfWidth);
+    void clear();
+
+    Vector2 evaluate(const PatrolPath &path, double distance,
+        Vector2 *direction) const;
+    Vector2 evaluateAt(const PatrolPath &path, float speed, double time,
+        Vector2 *velocity) const;
+    Rectangle getBounds(const PatrolPath &path) const;
+    int getPointCount() const { return (int) mPoints.size(); }
+};
+
+#endif // PATROL_PATH_H
@@ -0,0 +1,308 @@
+#include "Physics.h"
+#include "Entity.h"
+#include "Profiler.h"
+
+/**
+ * Adds a contact between the entity `handle` and packed candidate
+ * `candidate` to the scratch's contact list.
+ *
+ * @param velocity the entity's velocity as it touched, before any bounce.
+ */
+static inline void addContact(CollisionScratch &collision, EntityHandle handle,
+    int candidate, Vector2 normal, float penetration, Vector2 velocity, 
+    ContactKind kind)
+{
+    Contact contact;
+    contact.entity           = handle;
+    contact.other            = collision.handles[candidate];
+    contact.normal           = normal;
+    contact.penetration      = penetration;
+    contact.relativeVelocity = { velocity.x - collision.velocities[candidate].x,
+                                 velocity.y - collision.velocities[candidate].y };
+    contact.kind             = (unsigned char) kind;
+    collision.contacts.add(contact);
+}
+
+/**
+ * Resolves the entity's vertical move from `startY` to its current position
+ * against every packed collision candidate, adjusting its position and
+ * velocity. Every surface it stops at or is pushed out of is added to the
+ * scratch's contacts.
+ *
+ * The move is swept: the entity stops at the first surface it crosses on
+ * the way, however far the step took it, so a long step can't carry it
+ * through a thin collider. Overlaps the sweep doesn't account for (the
+ * entity started inside something, or bounced into it) are then pushed
+ * out as before.
+ *
+ * @param collision candidates packed by `CollisionScratch::gather()`.
+ * @param candidateCount The number of packed candidates. Which of them the
+ * move touched comes from one `BoxOverlapBatch()` call on the swept box.
+ * @param startY the entity's y position before this step's move.
+ */
+static void checkCollisionY(Body &body, CollisionScratch &collision, 
+    int candidateCount, float startY)
+{
+    PROFILE(PHASE_COLLISION_Y);
+    if (candidateCount == 0) return;
+
+    Vector2 &position    = body.position;
+    Vector2 &velocity    = body.velocity;
+    unsigned char &flags = body.flags;
+    Vector2 dimensions   = body.dimensions;
+    float motion         = position.y - startY;
+
+    Vector2 sweptCenter     = { position.x, startY + motion * 0.5f };
+    Vector2 sweptDimensions = { dimensions.x, dimensions.y + fabsf(motion) };
+
+    BoxOverlapBatch(sweptCenter, sweptDimensions, collision.positions, 
+        collision.dimensions, candidateCount, 
+        collision.hitMask, collision.xOverlaps, 
+        collision.yOverlaps);
+
+    // Earliest time of impact along the move
+    float firstImpact = 1.0f, firstContact = 0.0f;
+    int   firstIndex  = 0;
+    bool  impacted    = false;
+
+    for (int i = 0; i < candidateCount; i++)
+    {
+        float contact;
+        if (!IsHit(collision.hitMask, i)) continue;
+        if (!SweepAxis(startY, motion, collision.positions[i].y, 
+            (dimensions.y + collision.dimensions[i].y) * 0.5f, &contact)) continue;
+
+        float impact = (contact - startY) / motion;
+        if (!impacted || impact < firstImpact)
+        {
+            firstImpact  = impact;
+            firstContact = contact;
+            firstIndex   = i;
+            impacted     = true;
+        }
+    }
+
+    if (impacted)
+    {
+        addContact(collision, body.handle, firstIndex, 
+            { 0.0f, motion > 0.0f ? -1.0f : 1.0f }, 
+            fabsf(position.y - firstContact), velocity, CONTACT_SOLID);
+        position.y = firstContact;
+        velocity.y = -velocity.y * body.bounciness;
+        if (fabs(velocity.y) < Entity::MIN_BOUNCE_VELOCITY) velocity.y = 0.0f;
+        flags |= motion > 0.0f ? FLAG_COLLIDING_BOTTOM : FLAG_COLLIDING_TOP;
+    }
+
+    // Until something moves the entity, only what the swept box touched
+    // can overlap its end position
+    bool moved = impacted;
+
+    for (int i = 0; i < candidateCount; i++)
+    {
+        float xOverlap, yOverlap;
+        if (!moved && !IsHit(collision.hitMask, i)) continue;
+        if (!BoxOverlap(position, dimensions, collision.positions[i], 
+            collision.dimensions[i], &xOverlap, &yOverlap)) continue;
+
+        if (velocity.y > 0) 
+        {
+            addContact(collision, body.handle, i, { 0.0f, -1.0f }, yOverlap, 
+                velocity, CONTACT_SOLID);
+            position.y -= yOverlap;
+            velocity.y = -velocity.y * body.bounciness;
+            if (fabs(velocity.y) < Entity::MIN_BOUNCE_VELOCITY) velocity.y = 0.0f;
+            flags |= FLAG_COLLIDING_BOTTOM;
+            moved = true;
+        } else if (velocity.y < 0) 
+        {
+            addContact(collision, body.handle, i, { 0.0f, 1.0f }, yOverlap, 
+                velocity, CONTACT_SOLID);
+            position.y += yOverlap;
+            velocity.y = -velocity.y * body.bounciness;
+            if (fabs(velocity.y) < Entity::MIN_BOUNCE_VELOCITY) velocity.y = 0.0f;
+            flags |= FLAG_COLLIDING_TOP;
+            moved = true;
+        }
+    }
+}
+
+/**
+ * Horizontal counterpart of `checkCollisionY()`, sweeping the move from
+ * `startX`. Candidates the entity only grazes vertically are ignored.
+ */
+static void checkCollisionX(Body &body, CollisionScratch &collision, 
+    int candidateCount, float startX)
+{
+    PROFILE(PHASE_COLLISION_X);
+    if (candidateCount == 0) return;
+
+    Vector2 &position    = body.position;
+    Vector2 &velocity    = body.velocity;
+    unsigned char &flags = body.flags;
+    Vector2 dimensions   = body.dimensions;
+    float motion         = position.x - startX;
+
+    Vector2 sweptCenter     = { startX + motion * 0.5f, position.y };
+    Vector2 sweptDimensions = { dimensions.x + fabsf(motion), dimensions.y };
+
+    BoxOverlapBatch(sweptCenter, sweptDimensions, collision.positions, 
+        collision.dimensions, candidateCount, 
+        collision.hitMask, collision.xOverlaps, 
+        collision.yOverlaps);
+
+    // When standing on a platform, we're always slightly overlapping
+    // it vertically due to gravity, which causes false horizontal
+    // collision detections. So the solution I dound is only resolve X
+    // collisions if there's significant Y overlap, preventing the 
+    // platform we're standing on from acting like a wall. The move is
+    // horizontal, so the swept box's Y overlap is the real one.
+    float firstImpact = 1.0f, firstContact = 0.0f;
+    int   firstIndex  = 0;
+    bool  impacted    = false;
+
+    for (int i = 0; i < candidateCount; i++)
+    {
+        float contact;
+        if (!IsHit(collision.hitMask, i)) continue;
+        if (collision.yOverlaps[i] < Entity::Y_COLLISION_THRESHOLD) continue;
+        if (!SweepAxis(startX, motion, collision.positions[i].x, 
+            (dimensions.x + collision.dimensions[i].x) * 0.5f, &contact)) continue;
+
+        float impact = (contact - startX) / motion;
+        if (!impacted || impact < firstImpact)
+        {
+            firstImpact  = impact;
+            firstContact = contact;
+            firstIndex   = i;
+            impacted     = true;
+        }
+    }
+
+    if (impacted)
+    {
+        addContact(collision, body.handle, firstIndex, 
+            { motion > 0.0f ? -1.0f : 1.0f, 0.0f }, 
+            fabsf(position.x - firstContact), velocity, CONTACT_SOLID);
+        position.x = firstContact;
+        velocity.x = -velocity.x * body.bounciness;
+        if (fabs(velocity.x) < Entity::MIN_BOUNCE_VELOCITY) velocity.x = 0.0f;
+        flags |= motion > 0.0f ? FLAG_COLLIDING_RIGHT : FLAG_COLLIDING_LEFT;
+    }
+
+    bool moved = impacted;
+
+    for (int i = 0; i < candidateCount; i++)
+    {
+        float xOverlap, yOverlap;
+        if (!moved && !IsHit(collision.hitMask, i)) continue;
+        if (!BoxOverlap(position, dimensions, collision.positions[i], 
+            collision.dimensions[i], &xOverlap, &yOverlap)) continue;
+        if (yOverlap < Entity::Y_COLLISION_THRESHOLD) continue;
+
+        if (velocity.x > 0) {
+            addContact(collision, body.handle, i, { -1.0f, 0.0f }, xOverlap, 
+                velocity, CONTACT_SOLID);
+            position.x     -= xOverlap;
+            velocity.x     = -velocity.x * body.bounciness;
+            if (fabs(velocity.x) < Entity::MIN_BOUNCE_VELOCITY) velocity.x = 0.0f;
+
+            // Collision!
+            flags |= FLAG_COLLIDING_RIGHT;
+            moved = true;
+        } else if (velocity.x < 0) {
+            addContact(collision, body.handle, i, { 1.0f, 0.0f }, xOverlap, 
+                velocity, CONTACT_SOLID);
+            position.x    += xOverlap;
+            velocity.x     = -velocity.x * body.bounciness;
+            if (fabs(velocity.x) < Entity::MIN_BOUNCE_VELOCITY) velocity.x = 0.0f;
+ 
+            // Collision!
+            flags |= FLAG_COLLIDING_LEFT;
+            moved = true;
+        }
+    }
+}
+
+/**
+ * Adds a sensor contact for every packed candidate whose sensor volume the
+ * entity's collider overlaps where it ended the step. Nothing is resolved;
+ * game rules read these to decide what the entity touched, in place of
+ * testing the pair again themselves. The normal is the axis of least
+ * overlap.
+ */
+static void findSensorContacts(const Body &body, 
+    CollisionScratch &collision, int candidateCount)
+{
+    if (collision.sensorCount == 0) return;
+
+    Vector2 position   = body.position;
+    Vector2 velocity   = body.velocity;
+    Vector2 dimensions = body.dimensions;
+
+    BoxOverlapBatch(position, dimensions, collision.positions, 
+        collision.sensorDimensions, candidateCount, collision.hitMask, 
+        collision.xOverlaps, collision.yOverlaps);
+
+    for (int i = 0; i < candidateCount; i++)
+    {
+        // A zero-sized box still overlaps anything around its centre
+        if (!IsHit(collision.hitMask, i)) continue;
+        if (collision.sensorDimensions[i].x <= 0.0f) continue;
+
+        float xOverlap = collision.xOverlaps[i];
+        float yOverlap = collision.yOverlaps[i];
+        Vector2 offset = { position.x - collision.positions[i].x,
+                           position.y - collision.positions[i].y };
+
+        if (xOverlap < yOverlap)
+            addContact(collision, body.handle, i, 
+                { offset.x < 0.0f ? -1.0f : 1.0f, 0.0f }, xOverlap, velocity, 
+                CONTACT_SENSOR);
+        else
+            addContact(collision, body.handle, i, 
+                { 0.0f, offset.y < 0.0f ? -1.0f : 1.0f }, yOverlap, velocity, 
+                CONTACT_SENSOR);
+    }
+}
+
+/**
+ * The physics step: integrates `body` over `deltaTime`, then moves it one
+ * axis at a time, resolving each move against the first `candidateCount`
+ * candidates packed in `collision`, and lists every contact it made in the
+ * scratch's contacts. Candidates are resolved in the order they are packed.
+ *
+ * Horizontal velocity follows the acceleration and is damped while there
+ * is none; vertical velocity takes the acceleration and the jump impulse.
+ */
+void StepBody(Body &body, float deltaTime, CollisionScratch &collision, 
+    int candidateCount)
+{
+    Vector2 &position    = body.position;
+    Vector2 &velocity    = body.velocity;
+    Vector2 acceleration = body.acceleration;
+
+    {
+        PROFILE(PHASE_INTEGRATE);
+        body.flags &= ~FLAG_COLLIDING_ANY;
+
+        // Horizontal velocity is driven by acceleration (set via input)
+        velocity.x += acceleration.x * deltaTime;
+
+        if (fabs(acceleration.x) < 0.0001f) {
+            velocity.x = velocity.x / 
+                (1.0f + Entity::HORIZONTAL_DAMPING * deltaTime);
+        }
+
+        // Apply vertical acceleration (gravity) to velocity
+        velocity.y += acceleration.y * deltaTime;
+        velocity.y -= body.jumpImpulse;
+    }
+
+    float startY = position.y;
+    position.y += velocity.y * deltaTime;
+    checkCollisionY(body, collision, candidateCount, startY);
+    float startX = position.x;
+    position.x += velocity.x * deltaTime;
+    checkCollisionX(body, collision, candidateCount, startX);
+    findSensorContacts(body, collision, candidateCount);
+}
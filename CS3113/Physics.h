@@ -0,0 +1,27 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include "Collision.h"
+
+/**
+ * Everything one step of physics reads and writes for a single moving
+ * body, as plain values. `Entity::update()` fills one from its store slots
+ * and `VecEnv` from its per-instance arrays, so both step birds with the
+ * same `StepBody()`.
+ */
+struct Body
+{
+    Vector2       position;
+    Vector2       velocity;
+    Vector2       acceleration;
+    Vector2       dimensions;    // collider
+    float         bounciness;
+    float         jumpImpulse;   // taken off the vertical velocity, 0 if none
+    unsigned char flags;         // `EntityFlag`s; the colliding ones are set
+    EntityHandle  handle;        // recorded as `Contact::entity`
+};
+
+void StepBody(Body &body, float deltaTime, CollisionScratch &collision, 
+    int candidateCount);
+
+#endif // PHYSICS_H
@@ -0,0 +1,142 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "Arena.h"
+#include <new>
+#include <utility>
+
+/**
+ * Refers to an object in a `Pool`. The generation tells a handle to a
+ * despawned object apart from one to whatever later reused its slot, so a
+ * stale handle just looks the object up as missing.
+ */
+struct PoolHandle
+{
+    int          index      = -1;
+    unsigned int generation = 0;
+
+    bool isValid() const { return index >= 0; }
+};
+
+/**
+ * Fixed-capacity storage for objects of one type, carved out of an `Arena`.
+ * Free slots form a linked list through an index array, so `spawn()` and
+ * `despawn()` are O(1) and never touch the heap, and objects never move, so
+ * pointers to them stay valid until they are despawned.
+ *
+ * Slot generations are odd while the slot is live and even while it is free.
+ */
+template <typename T>
+class Pool
+{
+private:
+    T            *mSlots       = nullptr;
+    unsigned int *mGenerations = nullptr;
+    int          *mNextFree    = nullptr;
+    int mCapacity = 0;
+    int mCount    = 0;
+    int mFreeHead = -1;
+
+    bool isLive(int index) const { return (mGenerations[index] & 1u) != 0; }
+
+public:
+    Pool() { }
+    ~Pool() { clear(); }
+
+    Pool(const Pool &) = delete;
+    Pool &operator=(const Pool &) = delete;
+
+    /**
+     * Takes room for `capacity` objects from `arena`, despawning anything
+     * the pool held before. The pool must be cleared before the arena is
+     * reset.
+     */
+    void init(Arena &arena, int capacity)
+    {
+        clear();
+
+        mSlots       = arena.allocateArray<T>(capacity);
+        mGenerations = arena.allocateArray<unsigned int>(capacity);
+        mNextFree    = arena.allocateArray<int>(capacity);
+        mCapacity    = mSlots && mGenerations && mNextFree ? capacity : 0;
+        mFreeHead    = mCapacity > 0 ? 0 : -1;
+
+        for (int i = 0; i < mCapacity; i++)
+        {
+            mGenerations[i] = 0;
+            mNextFree[i]    = i + 1 < mCapacity ? i + 1 : -1;
+        }
+    }
+
+    /**
+     * Constructs an object in a free slot.
+     *
+     * @return its handle, or an invalid one if the pool is full.
+     */
+    template <typename... Args>
+    PoolHandle spawn(Args &&... arguments)
+    {
+        PoolHandle handle;
+        if (mFreeHead < 0) return handle;
+
+        int index = mFreeHead;
+        mFreeHead = mNextFree[index];
+
+        new (&mSlots[index]) T(std::forward<Args>(arguments)...);
+        mGenerations[index]++;
+        mCount++;
+
+        handle.index      = index;
+        handle.generation = mGenerations[index];
+        return handle;
+    }
+
+    /**
+     * Destroys the object and frees its slot. Stale or invalid handles are
+     * ignored.
+     */
+    void despawn(PoolHandle handle)
+    {
+        if (!get(handle)) return;
+
+        mSlots[handle.index].~T();
+        mGenerations[handle.index]++;
+        mNextFree[handle.index] = mFreeHead;
+        mFreeHead = handle.index;
+        mCount--;
+    }
+
+    /**
+     * @return the object, or `nullptr` if it has been despawned.
+     */
+    T *get(PoolHandle handle) const
+    {
+        if (handle.index < 0 || handle.index >= mCapacity) return nullptr;
+        if (mGenerations[handle.index] != handle.generation) return nullptr;
+        return &mSlots[handle.index];
+    }
+
+    /**
+     * Despawns every live object. The storage stays with the pool until the
+     * next `init()`.
+     */
+    void clear()
+    {
+        if (mCount == 0) return;
+
+        for (int i = 0; i < mCapacity; i++)
+        {
+            if (!isLive(i)) continue;
+
+            PoolHandle handle;
+            handle.index      = i;
+            handle.generation = mGenerations[i];
+            despawn(handle);
+        }
+    }
+
+    int getCount()    const { return mCount;    }
+    int getCapacity() const { return mCapacity; }
+};
+
+#endif // POOL_H
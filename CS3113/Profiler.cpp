@@ -0,0 +1,246 @@
+#include "Profiler.h"
+#include <algorithm>
+
+constexpr int   Profiler::RING_SIZE;
+constexpr int   Profiler::HISTOGRAM_BUCKETS;
+constexpr float Profiler::HISTOGRAM_BUCKET_MS;
+
+static const char *PHASE_NAMES[PHASE_COUNT] = {
+    "frame", "input", "update", "render", "step",
+    "integrate", "collision_y", "collision_x", "animate", "history",
+    "latency"
+};
+
+Profiler::Profiler() { clear(); }
+
+Profiler &Profiler::shared()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+const char *Profiler::getPhaseName(ProfilePhase phase)
+{
+    return phase >= 0 && phase < PHASE_COUNT ? PHASE_NAMES[phase] : "unknown";
+}
+
+/**
+ * Appends one timing sample. Safe to call from any thread: the slot is
+ * claimed with a single atomic increment and filled with a single atomic
+ * store, so concurrent writers never block each other or tear a sample.
+ *
+ * @param phase which part of the frame was timed.
+ * @param nanoseconds how long it took.
+ */
+void Profiler::record(ProfilePhase phase, unsigned long long nanoseconds)
+{
+    unsigned long long frame = mFrame.load(std::memory_order_relaxed);
+    if (nanoseconds > DURATION_MASK) nanoseconds = DURATION_MASK;
+
+    unsigned long long sample =
+        ((unsigned long long) phase << PHASE_SHIFT) |
+        ((frame & FRAME_MASK) << FRAME_SHIFT) |
+        nanoseconds;
+
+    unsigned int slot = mHead.fetch_add(1, std::memory_order_relaxed);
+    mSamples[slot % RING_SIZE].store(sample, std::memory_order_relaxed);
+}
+
+void Profiler::clear()
+{
+    for (int i = 0; i < RING_SIZE; i++)
+        mSamples[i].store(0, std::memory_order_relaxed);
+    mHead.store(0);
+    mFrame.store(0);
+}
+
+/**
+ * Copies the durations (in milliseconds) of every sample of `phase` that is
+ * still in the ring, oldest first.
+ */
+std::vector<float> Profiler::collectDurations(ProfilePhase phase) const
+{
+    std::vector<float> durations;
+
+    unsigned int head  = mHead.load(std::memory_order_relaxed);
+    unsigned int count = std::min(head, (unsigned int) RING_SIZE);
+
+    for (unsigned int i = head - count; i != head; i++)
+    {
+        unsigned long long sample =
+            mSamples[i % RING_SIZE].load(std::memory_order_relaxed);
+
+        if ((int) (sample >> PHASE_SHIFT) != phase) continue;
+        durations.push_back((sample & DURATION_MASK) / 1.0e6f);
+    }
+
+    return durations;
+}
+
+/**
+ * Summarises the samples of `phase` currently in the ring. Every field is
+ * zero if there are none.
+ */
+Profiler::PhaseStats Profiler::getStats(ProfilePhase phase) const
+{
+    PhaseStats stats = { 0, 0.0f, 0.0f, 0.0f, 0.0f };
+    std::vector<float> durations = collectDurations(phase);
+    if (durations.empty()) return stats;
+
+    double total = 0.0;
+    stats.minMs  = durations[0];
+    stats.maxMs  = durations[0];
+
+    for (float duration : durations)
+    {
+        total += duration;
+        stats.minMs = std::min(stats.minMs, duration);
+        stats.maxMs = std::max(stats.maxMs, duration);
+    }
+
+    size_t p99Index = (durations.size() - 1) * 99 / 100;
+    std::nth_element(durations.begin(), durations.begin() + p99Index,
+        durations.end());
+
+    stats.count = (int) durations.size();
+    stats.avgMs = (float) (total / durations.size());
+    stats.p99Ms = durations[p99Index];
+
+    return stats;
+}
+
+/**
+ * Buckets the samples of `phase` into `HISTOGRAM_BUCKETS` bins of
+ * `HISTOGRAM_BUCKET_MS` each. The last bin also collects everything slower.
+ *
+ * @param buckets array of at least `HISTOGRAM_BUCKETS` counts to fill.
+ */
+void Profiler::getHistogram(ProfilePhase phase, int *buckets) const
+{
+    std::fill(buckets, buckets + HISTOGRAM_BUCKETS, 0);
+
+    for (float duration : collectDurations(phase))
+    {
+        int bucket = (int) (duration / HISTOGRAM_BUCKET_MS);
+        buckets[std::min(bucket, HISTOGRAM_BUCKETS - 1)]++;
+    }
+}
+
+#ifndef HEADLESS
+/**
+ * Draws a table of min/avg/p99 per phase and a frame-time histogram with
+ * its top-left corner at (`x`, `y`).
+ */
+void Profiler::drawOverlay(int x, int y) const
+{
+    const int fontSize   = 10;
+    const int lineHeight = 12;
+    const int width      = 260;
+    const int histogramHeight = 40;
+
+    DrawRectangle(x, y, width,
+        (PHASE_COUNT + 2) * lineHeight + histogramHeight + 12,
+        Fade(BLACK, 0.7f));
+
+    char line[96];
+    snprintf(line, sizeof(line), "%-12s %7s %7s %7s",
+        "phase (ms)", "min", "avg", "p99");
+    DrawText(line, x + 6, y + 4, fontSize, YELLOW);
+
+    for (int i = 0; i < PHASE_COUNT; i++)
+    {
+        PhaseStats stats = getStats((ProfilePhase) i);
+        snprintf(line, sizeof(line), "%-12s %7.3f %7.3f %7.3f",
+            PHASE_NAMES[i], stats.minMs, stats.avgMs, stats.p99Ms);
+        DrawText(line, x + 6, y + 4 + (i + 1) * lineHeight, fontSize,
+            stats.count > 0 ? WHITE : GRAY);
+    }
+
+    int buckets[HISTOGRAM_BUCKETS];
+    getHistogram(PHASE_FRAME, buckets);
+
+    int tallest = 1;
+    for (int count : buckets) tallest = std::max(tallest, count);
+
+    int top       = y + 4 + (PHASE_COUNT + 1) * lineHeight + 4;
+    int barWidth  = (width - 12) / HISTOGRAM_BUCKETS;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+        int height = buckets[i] * histogramHeight / tallest;
+        DrawRectangle(x + 6 + i * barWidth, top + histogramHeight - height,
+            barWidth - 1, height, SKYBLUE);
+    }
+
+    snprintf(line, sizeof(line), "frame time, %.0f ms per bar",
+        HISTOGRAM_BUCKET_MS);
+    DrawText(line, x + 6, top + histogramHeight + 2, fontSize, WHITE);
+}
+#endif // HEADLESS
+
+/**
+ * Writes one row per sample in the ring: frame number, phase name and
+ * duration in microseconds.
+ *
+ * @return false if the file could not be written.
+ */
+bool Profiler::exportCSV(const char *filepath) const
+{
+    FILE *file = fopen(filepath, "w");
+    if (!file) return false;
+
+    fprintf(file, "frame,phase,microseconds\n");
+
+    unsigned int head  = mHead.load(std::memory_order_relaxed);
+    unsigned int count = std::min(head, (unsigned int) RING_SIZE);
+
+    for (unsigned int i = head - count; i != head; i++)
+    {
+        unsigned long long sample =
+            mSamples[i % RING_SIZE].load(std::memory_order_relaxed);
+
+        fprintf(file, "%llu,%s,%.3f\n",
+            (sample >> FRAME_SHIFT) & FRAME_MASK,
+            getPhaseName((ProfilePhase) (sample >> PHASE_SHIFT)),
+            (sample & DURATION_MASK) / 1.0e3);
+    }
+
+    bool ok = !ferror(file);
+    return fclose(file) == 0 && ok;
+}
+
+/**
+ * Writes the per-phase statistics and histograms as a JSON object keyed by
+ * phase name.
+ *
+ * @return false if the file could not be written.
+ */
+bool Profiler::exportJSON(const char *filepath) const
+{
+    FILE *file = fopen(filepath, "w");
+    if (!file) return false;
+
+    fprintf(file, "{\n  \"frames\": %u,\n  \"histogram_bucket_ms\": %.1f,\n"
+        "  \"phases\": {\n", getFrame(), HISTOGRAM_BUCKET_MS);
+
+    for (int i = 0; i < PHASE_COUNT; i++)
+    {
+        PhaseStats stats = getStats((ProfilePhase) i);
+        int buckets[HISTOGRAM_BUCKETS];
+        getHistogram((ProfilePhase) i, buckets);
+
+        fprintf(file, "    \"%s\": {\"count\": %d, \"min_ms\": %.4f, "
+            "\"avg_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f, "
+            "\"histogram\": [", PHASE_NAMES[i], stats.count, stats.minMs,
+            stats.avgMs, stats.p99Ms, stats.maxMs);
+
+        for (int b = 0; b < HISTOGRAM_BUCKETS; b++)
+            fprintf(file, b == 0 ? "%d" : ", %d", buckets[b]);
+
+        fprintf(file, "]}%s\n", i + 1 < PHASE_COUNT ? "," : "");
+    }
+
+    fprintf(file, "  }\n}\n");
+
+    bool ok = !ferror(file);
+    return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,108 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "cs3113.h"
+#include <atomic>
+#include <chrono>
+
+// Parts of a frame that can be timed with `PROFILE()`
+enum ProfilePhase
+{
+    PHASE_FRAME,
+    PHASE_INPUT,
+    PHASE_UPDATE,
+    PHASE_RENDER,
+    PHASE_STEP,
+    PHASE_INTEGRATE,
+    PHASE_COLLISION_Y,
+    PHASE_COLLISION_X,
+    PHASE_ANIMATE,
+    PHASE_HISTORY,
+    // Not a span of the frame: how long each input change waited before
+    // the step it belongs to applied it
+    PHASE_INPUT_LATENCY,
+    PHASE_COUNT
+};
+
+/**
+ * Collects phase timings into a fixed-size ring of samples that any thread
+ * can append to without locking; once full, the oldest samples are
+ * overwritten. Statistics, the overlay and the exports are all computed from
+ * whatever the ring currently holds, i.e. the last `RING_SIZE` samples.
+ *
+ * Samples are normally recorded through the `PROFILE()` macro in cs3113.h,
+ * which compiles to nothing unless the build defines `ENABLE_PROFILER`.
+ */
+class Profiler
+{
+public:
+    struct PhaseStats
+    {
+        int   count;
+        float minMs;
+        float avgMs;
+        float p99Ms;
+        float maxMs;
+    };
+
+    static constexpr int   RING_SIZE           = 1 << 14;
+    static constexpr int   HISTOGRAM_BUCKETS   = 20;
+    static constexpr float HISTOGRAM_BUCKET_MS = 2.0f;
+
+private:
+    // Each sample is packed into one word so it can be written atomically:
+    // phase in the top 5 bits, frame number in the next 24, nanoseconds in
+    // the low 35 (enough for ~34 s)
+    static constexpr int PHASE_SHIFT = 59;
+    static constexpr int FRAME_SHIFT = 35;
+    static constexpr unsigned long long FRAME_MASK    = (1ull << 24) - 1;
+    static constexpr unsigned long long DURATION_MASK = (1ull << 35) - 1;
+
+    std::atomic<unsigned long long> mSamples[RING_SIZE];
+    std::atomic<unsigned int>       mHead  {0};
+    std::atomic<unsigned int>       mFrame {0};
+
+    std::vector<float> collectDurations(ProfilePhase phase) const;
+
+    Profiler();
+
+public:
+    static Profiler &shared();
+
+    void record(ProfilePhase phase, unsigned long long nanoseconds);
+    void nextFrame() { mFrame.fetch_add(1, std::memory_order_relaxed); }
+    void clear();
+
+    PhaseStats getStats(ProfilePhase phase) const;
+    void getHistogram(ProfilePhase phase, int *buckets) const;
+    unsigned int getFrame() const { return mFrame.load(std::memory_order_relaxed); }
+
+    static const char *getPhaseName(ProfilePhase phase);
+
+    void drawOverlay(int x, int y) const;
+    bool exportCSV(const char *filepath) const;
+    bool exportJSON(const char *filepath) const;
+};
+
+/**
+ * Records the time between its construction and destruction under `phase`.
+ */
+class ProfileScope
+{
+private:
+    ProfilePhase mPhase;
+    std::chrono::steady_clock::time_point mStart;
+
+public:
+    explicit ProfileScope(ProfilePhase phase) : mPhase {phase},
+        mStart {std::chrono::steady_clock::now()} { }
+
+    ~ProfileScope()
+    {
+        Profiler::shared().record(mPhase,
+            (unsigned long long) std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - mStart).count());
+    }
+};
+
+#endif // PROFILER_H
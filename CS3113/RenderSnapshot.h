@@ -0,0 +1,47 @@
+#ifndef RENDER_SNAPSHOT_H
+#define RENDER_SNAPSHOT_H
+
+#include "cs3113.h"
+#include <chrono>
+
+// What drawing one entity needs from the simulation, taken by
+// `Entity::capture()`
+struct EntityRenderState
+{
+    Vector2       previousPosition;
+    Vector2       position;
+    float         angle;
+    int           frameIndex;
+    unsigned char direction;
+    bool          isActive;
+
+    // Blended from the previous position to the current one by `alpha`
+    Vector2 getInterpolatedPosition(float alpha) const
+    {
+        return {
+            previousPosition.x + (position.x - previousPosition.x) * alpha,
+            previousPosition.y + (position.y - previousPosition.y) * alpha
+        };
+    }
+};
+
+/**
+ * Everything the render thread reads from the simulation, copied out after
+ * a batch of fixed steps and handed over through a `TripleBuffer`. Once
+ * published it is never written again, so drawing it needs no locks and
+ * never sees a half-finished step.
+ */
+struct RenderSnapshot
+{
+    // One per entity, in the order the level spawned them
+    std::vector<EntityRenderState> entities;
+    int fuel      = 0;
+    int gameState = 0;
+
+    // Fixed steps simulated so far, and when the last of them was due;
+    // positions are interpolated over the step that follows it
+    unsigned long long                    stepCount = 0;
+    std::chrono::steady_clock::time_point stepTime;
+};
+
+#endif // RENDER_SNAPSHOT_H
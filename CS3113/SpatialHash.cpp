@@ -0,0 +1,254 @@
+#include "SpatialHash.h"
+#include <algorithm>
+
+constexpr float SpatialHash::DEFAULT_CELL_SIZE;
+
+SpatialHash::SpatialHash() : 
+    SpatialHash(DEFAULT_CELL_SIZE, 
+        { 0.0f, 0.0f, (float) SCREEN_WIDTH, (float) SCREEN_HEIGHT }) { }
+
+SpatialHash::SpatialHash(float cellSize, Rectangle bounds) : 
+    mCellSize {cellSize > 0.0f ? cellSize : DEFAULT_CELL_SIZE}, 
+    mBounds {bounds}
+{
+    mInverseCellSize = 1.0f / mCellSize;
+    mColumns = (int) ceilf(mBounds.width  / mCellSize);
+    mRows    = (int) ceilf(mBounds.height / mCellSize);
+    if (mColumns < 1) mColumns = 1;
+    if (mRows    < 1) mRows    = 1;
+
+    mCellStart.assign(mColumns * mRows + 1, 0);
+}
+
+/**
+ * Clamps a coordinate measured in cells to a valid cell index. Negative
+ * coordinates land in cell 0, so plain truncation is enough to floor the rest.
+ */
+static inline int clampToCell(float cellCoordinate, int cellCount)
+{
+    if (cellCoordinate <= 0.0f)              return 0;
+    if (cellCoordinate >= (float) cellCount) return cellCount - 1;
+    return (int) cellCoordinate;
+}
+
+/**
+ * The box an entity is bucketed by: its collider, grown to cover its sensor
+ * volume if it has one.
+ */
+static inline Vector2 getExtent(const EntityStore &store, EntityHandle handle)
+{
+    Vector2 collider = store.colliderDimensions[handle];
+    Vector2 sensor   = store.sensorDimensions[handle];
+
+    return { collider.x > sensor.x ? collider.x : sensor.x,
+             collider.y > sensor.y ? collider.y : sensor.y };
+}
+
+/**
+ * Converts an axis-aligned box into the inclusive range of grid cells it
+ * overlaps, clamped to the grid.
+ */
+void SpatialHash::getCellRange(Vector2 center, Vector2 dimensions, 
+    int *minColumn, int *minRow, int *maxColumn, int *maxRow) const
+{
+    float halfWidth  = dimensions.x / 2.0f;
+    float halfHeight = dimensions.y / 2.0f;
+
+    *minColumn = clampToCell((center.x - halfWidth  - mBounds.x) * mInverseCellSize, mColumns);
+    *maxColumn = clampToCell((center.x + halfWidth  - mBounds.x) * mInverseCellSize, mColumns);
+    *minRow    = clampToCell((center.y - halfHeight - mBounds.y) * mInverseCellSize, mRows);
+    *maxRow    = clampToCell((center.y + halfHeight - mBounds.y) * mInverseCellSize, mRows);
+}
+
+unsigned int SpatialHash::nextStamp() const
+{
+    if (++mCurrentStamp == 0)
+    {
+        // Wrapped around: old stamps could now collide with new ones
+        std::fill(mQueryStamps.begin(), mQueryStamps.end(), 0u);
+        mCurrentStamp = 1;
+    }
+    return mCurrentStamp;
+}
+
+/**
+ * Sizes the grid's buffers for `entityCount` entities up front, so that
+ * `rebuild()` and the queries don't grow them mid-step. Assumes colliders no
+ * bigger than a cell, which overlap at most four cells each; larger ones
+ * still work, they just grow the entry buffer once on the first rebuild.
+ */
+void SpatialHash::reserve(int entityCount)
+{
+    if (entityCount <= 0) return;
+
+    mEntries.reserve((size_t) entityCount * 4);
+    if ((int) mQueryStamps.size() < entityCount) mQueryStamps.resize(entityCount, 0u);
+}
+
+/**
+ * Re-buckets every active entity in the store. Runs in two passes over the
+ * store's arrays: one to count how many entries land in each cell, and one to
+ * scatter handles into place after a prefix sum over those counts. The
+ * scatter walks each cell's slot backwards, which leaves `mCellStart` holding
+ * the first entry of every cell once it is done.
+ * 
+ * @param store the entity arrays to index; handles in query results refer to
+ * this store.
+ */
+void SpatialHash::rebuild(const EntityStore &store)
+{
+    const int count = store.size();
+    const int cells = mColumns * mRows;
+    int *cellStart  = mCellStart.data();
+
+    std::fill(mCellStart.begin(), mCellStart.end(), 0);
+    mMaxDimensions = { 0.0f, 0.0f };
+
+    int minColumn, minRow, maxColumn, maxRow;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (!(store.flags[i] & FLAG_ACTIVE)) continue;
+
+        Vector2 dimensions = getExtent(store, i);
+        if (dimensions.x > mMaxDimensions.x) mMaxDimensions.x = dimensions.x;
+        if (dimensions.y > mMaxDimensions.y) mMaxDimensions.y = dimensions.y;
+
+        getCellRange(store.positions[i], dimensions, 
+            &minColumn, &minRow, &maxColumn, &maxRow);
+
+        for (int row = minRow; row <= maxRow; row++)
+            for (int column = minColumn; column <= maxColumn; column++)
+                cellStart[row * mColumns + column]++;
+    }
+
+    // Inclusive prefix sum: each cell now holds the end of its slot
+    for (int cell = 1; cell <= cells; cell++) cellStart[cell] += cellStart[cell - 1];
+
+    mEntries.resize(cellStart[cells]);
+    EntityHandle *entries = mEntries.data();
+
+    for (int i = count - 1; i >= 0; i--)
+    {
+        if (!(store.flags[i] & FLAG_ACTIVE)) continue;
+
+        getCellRange(store.positions[i], getExtent(store, i), 
+            &minColumn, &minRow, &maxColumn, &maxRow);
+
+        for (int row = minRow; row <= maxRow; row++)
+            for (int column = minColumn; column <= maxColumn; column++)
+                entries[--cellStart[row * mColumns + column]] = i;
+    }
+
+    if ((int) mQueryStamps.size() < count) mQueryStamps.resize(count, 0u);
+}
+
+/**
+ * Collects every entity bucketed in a cell that overlaps the given box. This
+ * is a broadphase result: candidates are only guaranteed to share a cell with
+ * the box, so callers still run their own overlap test.
+ * 
+ * @param center centre of the query box.
+ * @param dimensions full width and height of the query box.
+ * @param results cleared and filled with candidate handles, each reported
+ * once.
+ * @param exclude a handle to leave out, typically the querying entity.
+ * 
+ * @return the number of candidates written to `results`.
+ */
+int SpatialHash::queryRegion(Vector2 center, Vector2 dimensions, 
+    std::vector<EntityHandle> &results, EntityHandle exclude) const
+{
+    results.clear();
+
+    int minColumn, minRow, maxColumn, maxRow;
+    getCellRange(center, dimensions, &minColumn, &minRow, &maxColumn, &maxRow);
+
+    unsigned int stamp = nextStamp();
+
+    for (int row = minRow; row <= maxRow; row++)
+    {
+        for (int column = minColumn; column <= maxColumn; column++)
+        {
+            int cell = row * mColumns + column;
+
+            for (int e = mCellStart[cell]; e < mCellStart[cell + 1]; e++)
+            {
+                EntityHandle handle = mEntries[e];
+                if (handle == exclude || mQueryStamps[handle] == stamp) continue;
+
+                mQueryStamps[handle] = stamp;
+                results.push_back(handle);
+            }
+        }
+    }
+
+    return (int) results.size();
+}
+
+/**
+ * Finds the entity whose centre is closest to `point` by searching rings of
+ * cells outwards from the point's cell, stopping as soon as no unvisited ring
+ * could hold anything closer.
+ * 
+ * @param store the store the grid was last rebuilt from.
+ * @param point position to measure from.
+ * @param maxDistance ignore entities further away than this.
+ * @param exclude a handle to leave out, typically the querying entity.
+ * @param entityType only consider entities of this `EntityType`, or -1 for
+ * any type.
+ * 
+ * @return the closest entity's handle, or -1 if none is within range.
+ */
+EntityHandle SpatialHash::queryNearest(const EntityStore &store, Vector2 point, 
+    float maxDistance, EntityHandle exclude, int entityType) const
+{
+    int column, row, unused0, unused1;
+    getCellRange(point, { 0.0f, 0.0f }, &column, &row, &unused0, &unused1);
+
+    EntityHandle nearest   = -1;
+    float bestDistanceSq   = maxDistance * maxDistance;
+    int   maxRing          = mColumns > mRows ? mColumns : mRows;
+
+    for (int ring = 0; ring <= maxRing; ring++)
+    {
+        for (int r = row - ring; r <= row + ring; r++)
+        {
+            if (r < 0 || r >= mRows) continue;
+
+            for (int c = column - ring; c <= column + ring; c++)
+            {
+                if (c < 0 || c >= mColumns) continue;
+
+                // Only the outline of the ring; the inside was already visited
+                if (r != row - ring && r != row + ring && 
+                    c != column - ring && c != column + ring) continue;
+
+                int cell = r * mColumns + c;
+
+                for (int e = mCellStart[cell]; e < mCellStart[cell + 1]; e++)
+                {
+                    EntityHandle handle = mEntries[e];
+                    if (handle == exclude) continue;
+                    if (entityType >= 0 && store.types[handle] != entityType) continue;
+
+                    float dx = store.positions[handle].x - point.x;
+                    float dy = store.positions[handle].y - point.y;
+                    float distanceSq = dx * dx + dy * dy;
+
+                    if (distanceSq <= bestDistanceSq)
+                    {
+                        bestDistanceSq = distanceSq;
+                        nearest        = handle;
+                    }
+                }
+            }
+        }
+
+        // Anything in the next ring is at least `ring` cells away
+        float ringDistance = ring * mCellSize;
+        if (ringDistance * ringDistance >= bestDistanceSq) break;
+    }
+
+    return nearest;
+}
@@ -0,0 +1,59 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include "EntityStore.h"
+
+/**
+ * Uniform-grid broadphase over an `EntityStore`. Every active entity is
+ * bucketed into each cell its collider (or its sensor volume, where that is
+ * bigger) overlaps, so collision code only has to run the narrow phase
+ * against entities that share a cell with the area it cares about. Entities
+ * outside the bounds are clamped into the border cells.
+ * 
+ * The grid is rebuilt from scratch each step with a counting sort, which keeps
+ * each cell's entries contiguous and reuses the same buffers every time.
+ */
+class SpatialHash
+{
+private:
+    float     mCellSize;
+    float     mInverseCellSize;
+    Rectangle mBounds;
+    int       mColumns;
+    int       mRows;
+
+    std::vector<int>          mCellStart;   // cell c owns [mCellStart[c], mCellStart[c + 1])
+    std::vector<EntityHandle> mEntries;
+    Vector2                   mMaxDimensions = { 0.0f, 0.0f };
+
+    // Per-handle stamps used to report each entity once per query
+    mutable std::vector<unsigned int> mQueryStamps;
+    mutable unsigned int              mCurrentStamp = 0;
+
+    void getCellRange(Vector2 center, Vector2 dimensions, 
+        int *minColumn, int *minRow, int *maxColumn, int *maxRow) const;
+    unsigned int nextStamp() const;
+
+public:
+    static constexpr float DEFAULT_CELL_SIZE = 128.0f;
+
+    SpatialHash();
+    SpatialHash(float cellSize, Rectangle bounds);
+
+    void reserve(int entityCount);
+    void rebuild(const EntityStore &store);
+
+    int queryRegion(Vector2 center, Vector2 dimensions, 
+        std::vector<EntityHandle> &results, EntityHandle exclude = -1) const;
+    EntityHandle queryNearest(const EntityStore &store, Vector2 point, 
+        float maxDistance, EntityHandle exclude = -1, int entityType = -1) const;
+
+    float     getCellSize()      const { return mCellSize;      }
+    Rectangle getBounds()        const { return mBounds;        }
+    int       getColumns()       const { return mColumns;       }
+    int       getRows()          const { return mRows;          }
+    int       getEntryCount()    const { return (int) mEntries.size(); }
+    Vector2   getMaxDimensions() const { return mMaxDimensions; }
+};
+
+#endif // SPATIAL_HASH_H
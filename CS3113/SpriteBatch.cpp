@@ -0,0 +1,66 @@
+#include "SpriteBatch.h"
+#include <algorithm>
+
+#ifndef HEADLESS
+
+/**
+ * Starts a new frame's batch; sprites queued since the last `end()` are
+ * discarded.
+ */
+void SpriteBatch::begin()
+{
+    mSprites.clear();
+}
+
+/**
+ * Queues a sprite. Arguments match `DrawTexturePro()`, plus the layer the
+ * sprite belongs to: lower layers are drawn first, and draws within the same
+ * layer and texture keep their submission order.
+ */
+void SpriteBatch::draw(Texture2D texture, Rectangle source, 
+    Rectangle destination, Vector2 origin, float rotation, int layer, 
+    Color tint)
+{
+    Sprite sprite = { texture, source, destination, origin, rotation, tint, 
+                      layer, (int) mSprites.size() };
+    mSprites.push_back(sprite);
+}
+
+/**
+ * Sorts the queued sprites and draws them, counting a texture bind every
+ * time the texture changes.
+ *
+ * @param counter sampled after every sprite, if given, so flushes raylib
+ * makes in the middle of the batch are counted.
+ */
+void SpriteBatch::end(DrawCallCounter *counter)
+{
+    std::sort(mSprites.begin(), mSprites.end(), 
+        [](const Sprite &a, const Sprite &b) {
+            if (a.layer != b.layer)           return a.layer < b.layer;
+            if (a.texture.id != b.texture.id) return a.texture.id < b.texture.id;
+            return a.order < b.order;
+        });
+
+    mTextureBinds = 0;
+    mSpriteCount  = (int) mSprites.size();
+
+    unsigned int boundTexture = 0;
+
+    for (size_t i = 0; i < mSprites.size(); i++)
+    {
+        const Sprite &sprite = mSprites[i];
+
+        if (i == 0 || sprite.texture.id != boundTexture)
+        {
+            boundTexture = sprite.texture.id;
+            mTextureBinds++;
+        }
+
+        DrawTexturePro(sprite.texture, sprite.source, sprite.destination, 
+            sprite.origin, sprite.rotation, sprite.tint);
+        if (counter) counter->sample();
+    }
+}
+
+#endif // HEADLESS
@@ -0,0 +1,44 @@
+#ifndef SPRITE_BATCH_H
+#define SPRITE_BATCH_H
+
+#include "DrawCallCounter.h"
+
+/**
+ * Collects the sprites of a frame and submits them sorted by layer, then by
+ * texture. raylib already merges consecutive quads that use the same texture
+ * into one draw call, so ordering draws this way (and packing sprites into a
+ * shared atlas) keeps a whole scene down to a handful of draw calls. The
+ * batch counts how often it changes texture; `DrawCallCounter` counts the
+ * draw calls that actually result.
+ */
+class SpriteBatch
+{
+private:
+    struct Sprite
+    {
+        Texture2D texture;
+        Rectangle source;
+        Rectangle destination;
+        Vector2   origin;
+        float     rotation;
+        Color     tint;
+        int       layer;
+        int       order;
+    };
+
+    std::vector<Sprite> mSprites;
+
+    int mTextureBinds = 0;
+    int mSpriteCount  = 0;
+
+public:
+    void begin();
+    void draw(Texture2D texture, Rectangle source, Rectangle destination, 
+        Vector2 origin, float rotation, int layer, Color tint = WHITE);
+    void end(DrawCallCounter *counter = nullptr);
+
+    int getTextureBinds() const { return mTextureBinds; }
+    int getSpriteCount()  const { return mSpriteCount;  }
+};
+
+#endif // SPRITE_BATCH_H
@@ -0,0 +1,320 @@
+#include "TextureCache.h"
+#include "BakedTexture.h"
+#include <algorithm>
+
+/**
+ * The cache used by entities and the main loop; textures must all be released
+ * before the window closes.
+ */
+TextureCache &TextureCache::shared()
+{
+    static TextureCache cache;
+    return cache;
+}
+
+/**
+ * Returns the texture for a file, loading (see `LoadImagePreferBaked()`) and
+ * uploading it only if no one else currently holds it. Files that were
+ * packed into the atlas return the atlas texture; use `getRegion()` to find
+ * the file's part of it. Files reserved for the atlas but not yet packed
+ * return an empty texture.
+ * 
+ * @param textureFilepath path of the image file; also the cache key.
+ */
+Texture2D TextureCache::acquire(const char *textureFilepath)
+{
+    std::map<std::string, Entry>::iterator found = mEntries.find(textureFilepath);
+
+    if (found != mEntries.end())
+    {
+        found->second.referenceCount++;
+        return found->second.texture;
+    }
+
+    Entry entry = { {}, { 0.0f, 0.0f, 0.0f, 0.0f }, 1, false, false };
+    mLoadCount++;
+
+#ifndef HEADLESS
+    Image image = LoadImagePreferBaked(textureFilepath);
+    entry.texture = LoadTextureFromImage(image);
+    UnloadImage(image);
+    entry.region  = { 0.0f, 0.0f, (float) entry.texture.width, 
+                      (float) entry.texture.height };
+    mResidentBytes += GetPixelDataSize(entry.texture.width, 
+        entry.texture.height, entry.texture.format);
+#endif
+
+    mEntries[textureFilepath] = entry;
+    return entry.texture;
+}
+
+/**
+ * Drops one reference to a file's texture, unloading it from the GPU once
+ * nobody holds it any more. Releasing a path that is not cached does nothing.
+ */
+void TextureCache::release(const char *textureFilepath)
+{
+    std::map<std::string, Entry>::iterator found = mEntries.find(textureFilepath);
+    if (found == mEntries.end()) return;
+
+    if (--found->second.referenceCount > 0) return;
+
+    bool isPacked = found->second.isPacked;
+
+#ifndef HEADLESS
+    if (!isPacked && !found->second.isPending)
+    {
+        Texture2D texture = found->second.texture;
+        mResidentBytes -= GetPixelDataSize(texture.width, texture.height, 
+            texture.format);
+        UnloadTexture(texture);
+    }
+#endif
+
+    mEntries.erase(found);
+    if (isPacked) releaseAtlasReference();
+}
+
+void TextureCache::releaseAtlasReference()
+{
+    if (--mAtlasReferences > 0) return;
+
+#ifndef HEADLESS
+    mResidentBytes -= GetPixelDataSize(mAtlas.width, mAtlas.height, 
+        mAtlas.format);
+    UnloadTexture(mAtlas);
+#endif
+    mAtlas = {};
+}
+
+/**
+ * Claims the given files for the atlas before their pixels are available.
+ * Each one is pinned in the cache as `packAtlas()` would pin it, but has no
+ * texture until a later `packAtlas()` call supplies its image; entities can
+ * acquire it in the meantime. Files that are already cached are left alone.
+ */
+void TextureCache::reserveAtlas(const char *const *textureFilepaths, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (mEntries.count(textureFilepaths[i]) != 0) continue;
+
+        Entry entry = { {}, { 0.0f, 0.0f, 0.0f, 0.0f }, 1, false, true };
+        mEntries[textureFilepaths[i]] = entry;
+        mPackedFilepaths.push_back(textureFilepaths[i]);
+    }
+}
+
+/**
+ * Decodes the given files and packs them into one atlas; see the overload
+ * taking images.
+ * 
+ * @param textureFilepaths paths of the image files to pack.
+ * @param count number of paths.
+ * 
+ * @return `true` if an atlas was built.
+ */
+bool TextureCache::packAtlas(const char *const *textureFilepaths, int count)
+{
+#ifdef HEADLESS
+    (void) textureFilepaths;
+    (void) count;
+    return false;
+#else
+    std::vector<Image> images(count, Image {});
+    for (int i = 0; i < count; i++)
+    {
+        if (mEntries.count(textureFilepaths[i]) != 0 && 
+            !isPending(textureFilepaths[i])) continue;
+        images[i] = LoadImagePreferBaked(textureFilepaths[i]);
+    }
+
+    bool isPacked = packAtlas(textureFilepaths, images.data(), count);
+
+    for (int i = 0; i < count; i++)
+        if (images[i].data != NULL) UnloadImage(images[i]);
+    return isPacked;
+#endif
+}
+
+/**
+ * Packs already decoded images into one texture using rows ("shelves")
+ * sorted by height, trying power-of-two widths until the result is roughly
+ * square. Each packed file stays pinned in the cache until `releaseAtlas()`,
+ * so it survives entities coming and going.
+ * 
+ * Files reserved with `reserveAtlas()` are filled in, keeping whatever
+ * references entities already hold. Other files that are already cached on
+ * their own are left alone, as are images with no data. Only one atlas can
+ * exist at a time. Must be called on the thread that owns the window.
+ * 
+ * @param textureFilepaths paths the images were decoded from.
+ * @param images decoded images; the caller still owns (and unloads) them.
+ * @param count number of paths and images.
+ * 
+ * @return `true` if an atlas was built.
+ */
+bool TextureCache::packAtlas(const char *const *textureFilepaths, 
+    const Image *images, int count)
+{
+#ifdef HEADLESS
+    (void) textureFilepaths;
+    (void) images;
+    (void) count;
+    return false;
+#else
+    if (mAtlas.id != 0) return false;
+
+    std::vector<std::string> filepaths;
+    std::vector<Image>       packed;
+
+    for (int i = 0; i < count; i++)
+    {
+        std::map<std::string, Entry>::const_iterator found = 
+            mEntries.find(textureFilepaths[i]);
+        if (found != mEntries.end() && !found->second.isPending) continue;
+        if (std::find(filepaths.begin(), filepaths.end(), textureFilepaths[i]) 
+            != filepaths.end()) continue;
+        if (images[i].data == NULL) continue;
+
+        filepaths.push_back(textureFilepaths[i]);
+        packed.push_back(images[i]);
+    }
+
+    if (packed.empty()) return false;
+
+    // Tallest first keeps shelves tight
+    std::vector<int> order(packed.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = (int) i;
+    std::sort(order.begin(), order.end(), 
+        [&packed](int a, int b) { return packed[a].height > packed[b].height; });
+
+    std::vector<Rectangle> regions(packed.size());
+    int atlasWidth = 0, atlasHeight = 0;
+
+    for (int width = 256; width <= MAX_ATLAS_SIZE; width *= 2)
+    {
+        int x = 0, y = 0, shelfHeight = 0;
+        bool fits = true;
+
+        for (size_t n = 0; n < order.size() && fits; n++)
+        {
+            const Image &image = packed[order[n]];
+            int paddedWidth  = image.width  + ATLAS_PADDING;
+            int paddedHeight = image.height + ATLAS_PADDING;
+
+            if (paddedWidth > width) { fits = false; break; }
+
+            if (x + paddedWidth > width)
+            {
+                x  = 0;
+                y += shelfHeight;
+                shelfHeight = 0;
+            }
+
+            regions[order[n]] = { (float) x, (float) y, 
+                                  (float) image.width, (float) image.height };
+            x += paddedWidth;
+            if (paddedHeight > shelfHeight) shelfHeight = paddedHeight;
+        }
+
+        int height = 1;
+        while (height < y + shelfHeight) height *= 2;
+
+        if (fits && height <= MAX_ATLAS_SIZE && 
+            (height <= width || width == MAX_ATLAS_SIZE))
+        {
+            atlasWidth  = width;
+            atlasHeight = height;
+            break;
+        }
+    }
+
+    if (atlasWidth == 0) return false;
+
+    Image atlas = GenImageColor(atlasWidth, atlasHeight, BLANK);
+    for (size_t i = 0; i < packed.size(); i++)
+    {
+        Rectangle source = { 0.0f, 0.0f, (float) packed[i].width, 
+                             (float) packed[i].height };
+        ImageDraw(&atlas, packed[i], source, regions[i], WHITE);
+    }
+
+    mAtlas = LoadTextureFromImage(atlas);
+    UnloadImage(atlas);
+    mLoadCount++;
+    mResidentBytes += GetPixelDataSize(mAtlas.width, mAtlas.height, 
+        mAtlas.format);
+
+    for (size_t i = 0; i < filepaths.size(); i++)
+    {
+        std::map<std::string, Entry>::iterator found = mEntries.find(filepaths[i]);
+
+        if (found != mEntries.end())
+        {
+            // Reserved: the pin and any entity references carry over
+            found->second.texture   = mAtlas;
+            found->second.region    = regions[i];
+            found->second.isPacked  = true;
+            found->second.isPending = false;
+        }
+        else
+        {
+            Entry entry = { mAtlas, regions[i], 1, true, false };
+            mEntries[filepaths[i]] = entry;
+            mPackedFilepaths.push_back(filepaths[i]);
+        }
+        mAtlasReferences++;
+    }
+    mVersion++;
+
+    return true;
+#endif
+}
+
+/**
+ * Drops the pin `packAtlas()` holds on each packed file. The atlas itself is
+ * unloaded once every entity using it has released its file as well.
+ */
+void TextureCache::releaseAtlas()
+{
+    for (size_t i = 0; i < mPackedFilepaths.size(); i++)
+        release(mPackedFilepaths[i].c_str());
+    mPackedFilepaths.clear();
+}
+
+/**
+ * Returns the texture the file's pixels live in: the atlas once the file
+ * has been packed, otherwise its own texture. The id is 0 while a reserved
+ * file waits to be packed, and for files the cache doesn't know.
+ */
+Texture2D TextureCache::getTexture(const char *textureFilepath) const
+{
+    std::map<std::string, Entry>::const_iterator found = mEntries.find(textureFilepath);
+    if (found == mEntries.end()) return {};
+    return found->second.texture;
+}
+
+/**
+ * Returns the part of `getTexture(textureFilepath)` that holds the file's
+ * pixels: the whole texture unless the file was packed into the atlas, and
+ * an empty rectangle for files the cache doesn't know.
+ */
+Rectangle TextureCache::getRegion(const char *textureFilepath) const
+{
+    std::map<std::string, Entry>::const_iterator found = mEntries.find(textureFilepath);
+    if (found == mEntries.end()) return { 0.0f, 0.0f, 0.0f, 0.0f };
+    return found->second.region;
+}
+
+bool TextureCache::isPending(const char *textureFilepath) const
+{
+    std::map<std::string, Entry>::const_iterator found = mEntries.find(textureFilepath);
+    return found != mEntries.end() && found->second.isPending;
+}
+
+int TextureCache::getReferenceCount(const char *textureFilepath) const
+{
+    std::map<std::string, Entry>::const_iterator found = mEntries.find(textureFilepath);
+    return found == mEntries.end() ? 0 : found->second.referenceCount;
+}
@@ -0,0 +1,74 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include "cs3113.h"
+
+/**
+ * Loads each texture file once and shares the resulting GPU texture between
+ * every user of the same path. Each `acquire()` must be paired with a
+ * `release()`; the texture is unloaded when the last user releases it.
+ * 
+ * Files can also be packed together into one atlas texture with
+ * `packAtlas()`, in which case `acquire()` returns the shared atlas and
+ * `getRegion()` tells callers which part of it belongs to their file. Keeping
+ * every sprite on one texture lets raylib batch them into a single draw call.
+ * 
+ * Files can be reserved for the atlas before their pixels exist with
+ * `reserveAtlas()`, so entities can be created while images are still being
+ * decoded elsewhere (see `AssetLoader`). Until `packAtlas()` fills them in,
+ * `acquire()` hands out an empty texture; `getVersion()` changes whenever a
+ * file's texture or region does, telling holders to look theirs up again.
+ * 
+ * In headless builds nothing is decoded or uploaded: `acquire()` hands out a
+ * texture with no pixels, but reference counts are still tracked.
+ */
+class TextureCache
+{
+private:
+    struct Entry
+    {
+        Texture2D texture;
+        Rectangle region;
+        int       referenceCount;
+        bool      isPacked;
+        bool      isPending;
+    };
+
+    std::map<std::string, Entry> mEntries;
+    size_t mResidentBytes = 0;
+    int    mLoadCount     = 0;
+    int    mVersion       = 0;
+
+    Texture2D mAtlas = {};
+    int       mAtlasReferences = 0;
+    std::vector<std::string> mPackedFilepaths;
+
+    void releaseAtlasReference();
+
+public:
+    static constexpr int MAX_ATLAS_SIZE = 4096;
+    static constexpr int ATLAS_PADDING  = 2;
+
+    static TextureCache &shared();
+
+    Texture2D acquire(const char *textureFilepath);
+    void release(const char *textureFilepath);
+
+    void reserveAtlas(const char *const *textureFilepaths, int count);
+    bool packAtlas(const char *const *textureFilepaths, int count);
+    bool packAtlas(const char *const *textureFilepaths, const Image *images, 
+        int count);
+    void releaseAtlas();
+
+    Texture2D getTexture(const char *textureFilepath) const;
+    Rectangle getRegion(const char *textureFilepath) const;
+    bool   isPending(const char *textureFilepath) const;
+    int    getVersion()           const { return mVersion;              }
+    Texture2D getAtlas()          const { return mAtlas;                }
+    int    getTextureCount()      const { return (int) mEntries.size(); }
+    int    getLoadCount()         const { return mLoadCount;            }
+    size_t getResidentBytes()     const { return mResidentBytes;        }
+    int    getReferenceCount(const char *textureFilepath) const;
+};
+
+#endif // TEXTURE_CACHE_H
@@ -0,0 +1,87 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+/**
+ * Hands whole values from one writer thread to one reader thread without
+ * either ever waiting on the other. There are three slots: the writer fills
+ * its back slot, the reader draws from its front slot, and `publish()` and
+ * `acquire()` each swap their own slot with the one in the middle in a
+ * single atomic exchange.
+ *
+ * The reader always gets the latest value published. Values it was too slow
+ * to pick up are simply overwritten, and a writer that is faster than the
+ * reader never blocks it.
+ *
+ *     // writer                         // reader
+ *     T &next = buffer.getWriteBuffer();  buffer.acquire();
+ *     ...fill in next...                 draw(buffer.getReadBuffer());
+ *     buffer.publish();
+ */
+template <typename T>
+class TripleBuffer
+{
+private:
+    // The middle slot's index, with NEW_BIT set while it holds a value the
+    // reader hasn't taken yet
+    static constexpr unsigned int INDEX_MASK = 3;
+    static constexpr unsigned int NEW_BIT    = 4;
+
+    T mSlots[3];
+    std::atomic<unsigned int> mMiddle {1};
+    unsigned int mBack  = 0;   // only touched by the writer
+    unsigned int mFront = 2;   // only touched by the reader
+
+public:
+    TripleBuffer() { }
+
+    TripleBuffer(const TripleBuffer &) = delete;
+    TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+    /**
+     * Copies `value` into every slot, so both sides start from it. Only call
+     * this while neither thread is using the buffer.
+     */
+    void reset(const T &value)
+    {
+        for (T &slot : mSlots) slot = value;
+
+        mBack  = 0;
+        mFront = 2;
+        mMiddle.store(1, std::memory_order_release);
+    }
+
+    // The writer's slot. Whatever was in it is stale; overwrite all of it
+    T &getWriteBuffer() { return mSlots[mBack]; }
+
+    /**
+     * Makes the write buffer the latest value and gives the writer a slot
+     * the reader isn't using.
+     */
+    void publish()
+    {
+        mBack = mMiddle.exchange(mBack | NEW_BIT, std::memory_order_acq_rel) &
+            INDEX_MASK;
+    }
+
+    /**
+     * Takes the latest published value as the read buffer, if one has been
+     * published since the last call.
+     *
+     * @return false if the read buffer is unchanged.
+     */
+    bool acquire()
+    {
+        if ((mMiddle.load(std::memory_order_relaxed) & NEW_BIT) == 0) return false;
+
+        mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) &
+            INDEX_MASK;
+        return true;
+    }
+
+    // The reader's slot, valid until its next `acquire()`
+    const T &getReadBuffer() const { return mSlots[mFront]; }
+};
+
+#endif // TRIPLE_BUFFER_H
@@ -0,0 +1,284 @@
+#include "VecEnv.h"
+#include "Physics.h"
+
+/**
+ * A spawn coordinate drawn the way `Level::spawn()` draws it: fixed where
+ * the range is empty, otherwise an integer from the instance's generator.
+ */
+static inline float spawnCoordinate(float min, float max, unsigned int &state)
+{
+    return min == max ? min : (float) RandomInt(state, (int) min, (int) max);
+}
+
+/**
+ * Takes the level's first player as every instance's bird and everything
+ * else as its hazards, sizes the arrays for `instanceCount` instances and
+ * spawns them all. Instance `i` draws its spawns from its own generator,
+ * seeded from `seed + i`, so runs are reproducible and instances differ.
+ *
+ * @return false if the level has no player or `instanceCount` isn't
+ * positive.
+ */
+bool VecEnv::init(const Level &level, int instanceCount, unsigned int seed)
+{
+    int birdRecord = -1;
+    for (int i = 0; i < level.getEntityCount() && birdRecord < 0; i++)
+        if (level.getEntity(i).type == PLAYER) birdRecord = i;
+
+    if (birdRecord < 0 || instanceCount <= 0) return false;
+
+    mHazardSpawnMin.clear();
+    mHazardSpawnMax.clear();
+    mHazardDimensions.clear();
+    mHazardSensorDimensions.clear();
+    mHazardSpeeds.clear();
+    mHazardTypes.clear();
+    mRoutes.clear();
+    mHazardRoutes.clear();
+    mHazardHasPath.clear();
+    mHazardIndices.clear();
+    mSensorCount = 0;
+
+    std::vector<Vector2> points;
+    for (int i = 0; i < level.getEntityCount(); i++)
+    {
+        const LevelEntity &record = level.getEntity(i);
+        Vector2 spawnMin   = { record.spawnMin[0], record.spawnMin[1] };
+        Vector2 spawnMax   = { record.spawnMax[0], record.spawnMax[1] };
+        Vector2 dimensions = { record.scale[0], record.scale[1] };
+
+        if (i == birdRecord)
+        {
+            mBirdSpawnMin   = spawnMin;
+            mBirdSpawnMax   = spawnMax;
+            mBirdDimensions = dimensions;
+            // As `Entity`: animated entities fall, single images don't
+            mBirdGravity    = record.clipIndex >= 0 ? Entity::GRAVITY : 0.0f;
+            mBirdBounciness = record.bounciness >= 0.0f ? record.bounciness :
+                Entity::DEFAULT_BOUNCINESS;
+            continue;
+        }
+
+        mHazardSpawnMin.push_back(spawnMin);
+        mHazardSpawnMax.push_back(spawnMax);
+        mHazardDimensions.push_back(dimensions);
+        mHazardSensorDimensions.push_back({ record.sensor[0], record.sensor[1] });
+        mHazardSpeeds.push_back(record.patrolSpeed);
+        mHazardTypes.push_back(record.type);
+
+        points.resize(record.pointCount);
+        for (int p = 0; p < record.pointCount; p++)
+            points[p] = level.getPoint(record.firstPoint + p);
+        mHazardRoutes.push_back(record.pointCount > 0 ?
+            mRoutes.add((PatrolKind) record.pathKind, points.data(),
+                record.pointCount) :
+            mRoutes.addEdgeToEdge(dimensions.x / 2.0f));
+        mHazardHasPath.push_back(record.pointCount > 0);
+        mHazardIndices.push_back((EntityHandle) mHazardIndices.size());
+        mSensorCount += record.sensor[0] > 0.0f;
+    }
+
+    // Spawns are drawn in file order, like `Level::spawn()`, so a hazard
+    // listed before the bird draws first
+    mBirdRecord    = birdRecord;
+    mInstanceCount = instanceCount;
+    mHazardCount   = (int) mHazardTypes.size();
+
+    mPositions.assign(instanceCount, { 0.0f, 0.0f });
+    mVelocities.assign(instanceCount, { 0.0f, 0.0f });
+    mAccelerationsX.assign(instanceCount, 0.0f);
+    mFuel.assign(instanceCount, Entity::MAX_FUEL);
+    mFuelAccumulators.assign(instanceCount, 0.0f);
+    mOutcomes.assign(instanceCount, EPISODE_RUNNING);
+    mEpisodeSteps.assign(instanceCount, 0);
+    mRandomStates.resize(instanceCount);
+    mHazardPositions.assign((size_t) instanceCount * mHazardCount, { 0.0f, 0.0f });
+    mHazardVelocities.assign((size_t) instanceCount * mHazardCount, { 0.0f, 0.0f });
+    mHazardPaths.assign((size_t) instanceCount * mHazardCount, PatrolPath());
+
+    // A step stops the bird at most once per axis and pushes it out of each
+    // hazard at most once per axis, and touches each sensor at most once
+    mContactCapacity = 3 * mHazardCount + 2;
+    mXOverlaps.assign((size_t) instanceCount * mHazardCount, 0.0f);
+    mYOverlaps.assign((size_t) instanceCount * mHazardCount, 0.0f);
+    mHitMasks.assign((size_t) instanceCount * HitMaskWords(mHazardCount), 0u);
+    mContacts.assign((size_t) instanceCount * mContactCapacity, Contact());
+
+    for (int i = 0; i < instanceCount; i++)
+    {
+        unsigned int state = seed + (unsigned int) i;
+        mRandomStates[i] = state != 0 ? state : 0x9E3779B9u;
+    }
+
+    reset();
+    return true;
+}
+
+/**
+ * Starts a new episode in every instance. Each generator carries on from
+ * where it was, so the new spawns differ from the last ones.
+ */
+void VecEnv::reset()
+{
+    for (int i = 0; i < mInstanceCount; i++)
+    {
+        resetInstance(i);
+        mOutcomes[i] = EPISODE_RUNNING;
+    }
+}
+
+void VecEnv::resetInstance(int instance)
+{
+    unsigned int &state       = mRandomStates[instance];
+    Vector2 *hazardPositions  = &mHazardPositions[(size_t) instance * mHazardCount];
+    Vector2 *hazardVelocities = &mHazardVelocities[(size_t) instance * mHazardCount];
+    PatrolPath *paths         = &mHazardPaths[(size_t) instance * mHazardCount];
+
+    for (int record = 0, hazard = 0; record <= mHazardCount; record++)
+    {
+        if (record == mBirdRecord)
+        {
+            mPositions[instance].x = spawnCoordinate(mBirdSpawnMin.x, mBirdSpawnMax.x, state);
+            mPositions[instance].y = spawnCoordinate(mBirdSpawnMin.y, mBirdSpawnMax.y, state);
+            continue;
+        }
+
+        hazardPositions[hazard].x = spawnCoordinate(mHazardSpawnMin[hazard].x,
+            mHazardSpawnMax[hazard].x, state);
+        hazardPositions[hazard].y = spawnCoordinate(mHazardSpawnMin[hazard].y,
+            mHazardSpawnMax[hazard].y, state);
+        hazardVelocities[hazard] = { 0.0f, 0.0f };
+
+        // Placed as `EntityStore` places them
+        Vector2 spawn = hazardPositions[hazard];
+        PatrolPath &path = paths[hazard];
+        path = mHazardRoutes[hazard];
+        if (mHazardHasPath[hazard])
+        {
+            path.origin = spawn;
+        }
+        else
+        {
+            float halfWidth = mHazardDimensions[hazard].x / 2.0f;
+            path.origin = { 0.0f, spawn.y };
+            path.phase  = fminf(fmaxf(spawn.x - halfWidth, 0.0f), path.length);
+        }
+        hazard++;
+    }
+
+    mVelocities[instance]       = { 0.0f, 0.0f };
+    mAccelerationsX[instance]   = 0.0f;
+    mFuel[instance]             = Entity::MAX_FUEL;
+    mFuelAccumulators[instance] = 0.0f;
+    mEpisodeSteps[instance]     = 0;
+}
+
+/**
+ * Advances every instance one step.
+ *
+ * @param actions one bitmask of `InputFlag`s per instance; `INPUT_QUIT` is
+ * ignored.
+ * @param deltaTime length of the step in seconds.
+ */
+void VecEnv::step(const unsigned char *actions, float deltaTime)
+{
+    step(actions, deltaTime, 0, mInstanceCount);
+}
+
+/**
+ * Step for instances [`begin`, `end`) only. Instances share nothing they
+ * write, so disjoint ranges can be stepped on different threads at once.
+ */
+void VecEnv::step(const unsigned char *actions, float deltaTime, int begin,
+    int end)
+{
+    for (int i = begin; i < end; i++)
+    {
+        // Whoever finished last step has been playing a fresh episode since
+        if (mOutcomes[i] != EPISODE_RUNNING)
+        {
+            mOutcomes[i]     = EPISODE_RUNNING;
+            mEpisodeSteps[i] = 0;
+        }
+
+        stepInstance(i, actions[i], deltaTime);
+        mEpisodeSteps[i]++;
+
+        if (mOutcomes[i] != EPISODE_RUNNING)
+        {
+            int length = mEpisodeSteps[i];
+            resetInstance(i);
+            mEpisodeSteps[i] = length;
+        }
+    }
+}
+
+/**
+ * One fixed step of one instance: `applyInput()`, then `step()` from
+ * main.cpp, through the same rule and physics functions.
+ */
+void VecEnv::stepInstance(int instance, unsigned char action, float deltaTime)
+{
+    size_t first = (size_t) instance * mHazardCount;
+    Vector2 *hazardPositions  = &mHazardPositions[first];
+    Vector2 *hazardVelocities = &mHazardVelocities[first];
+    const PatrolPath *paths   = &mHazardPaths[first];
+
+    Body bird;
+    bird.position     = mPositions[instance];
+    bird.velocity     = mVelocities[instance];
+    bird.dimensions   = mBirdDimensions;
+    bird.bounciness   = mBirdBounciness;
+    bird.flags        = FLAG_ACTIVE;
+    bird.handle       = (EntityHandle) mBirdRecord;
+
+    bool isJumping = ApplyBirdInput(action, deltaTime, mFuel[instance],
+        mFuelAccumulators[instance], mAccelerationsX[instance]);
+    bird.acceleration = { mAccelerationsX[instance], mBirdGravity };
+    bird.jumpImpulse  = isJumping ? Entity::DEFAULT_JUMPING_POWER : 0.0f;
+
+    // Patrols, as `EntityStore::updatePatrols()`, at the time this step
+    // ends; `step()` counts the episode's steps so far
+    double time = (double) (mEpisodeSteps[instance] + 1) * deltaTime;
+
+    for (int h = 0; h < mHazardCount; h++)
+    {
+        if (mHazardTypes[h] != PLATFORM && mHazardTypes[h] != ENEMY) continue;
+
+        hazardPositions[h] = mRoutes.evaluateAt(paths[h],
+            mHazardSpeeds[h] * EntityStore::PLATFORM_SPEED_SCALE, time,
+            &hazardVelocities[h]);
+    }
+
+    // Every hazard is a candidate, packed in place
+    CollisionScratch collision;
+    collision.handles          = mHazardIndices.data();
+    collision.positions        = hazardPositions;
+    collision.dimensions       = mHazardDimensions.data();
+    collision.sensorDimensions = mHazardSensorDimensions.data();
+    collision.velocities       = hazardVelocities;
+    collision.xOverlaps        = &mXOverlaps[first];
+    collision.yOverlaps        = &mYOverlaps[first];
+    collision.hitMask          = &mHitMasks[(size_t) instance * 
+                                            HitMaskWords(mHazardCount)];
+    collision.capacity         = mHazardCount;
+    collision.sensorCount      = mSensorCount;
+    collision.contacts.contacts = &mContacts[(size_t) instance * 
+                                             mContactCapacity];
+    collision.contacts.capacity = mContactCapacity;
+
+    StepBody(bird, deltaTime, collision, mHazardCount);
+
+    mPositions[instance]  = bird.position;
+    mVelocities[instance] = bird.velocity;
+
+    if (!ConfineToScreen(mPositions[instance], mVelocities[instance],
+        mBirdDimensions, mBirdBounciness))
+    {
+        mOutcomes[instance] = EPISODE_LOST;
+        return;
+    }
+
+    mOutcomes[instance] = JudgeContacts(collision.contacts, 
+        mHazardTypes.data(), mVelocities[instance]);
+}
@@ -0,0 +1,115 @@
+#ifndef VEC_ENV_H
+#define VEC_ENV_H
+
+#include "BirdRules.h"
+#include "Entity.h"
+#include "Level.h"
+
+/**
+ * Many independent copies of the game, stepped together for automated
+ * players. Each instance plays the same rules as `step()` in main.cpp, with
+ * the same code: the level's platforms and enemies patrol
+ * (`PatrolRoutes::evaluateAt()`), the bird moves and bounces off them
+ * (`StepBody()`), and touching the nest's sensor (falling onto it) wins
+ * while touching a hawk's sensor or the bottom of the screen loses (see
+ * BirdRules.h). `make check-vecenv` plays both side by side.
+ *
+ * Instances are stored as structure-of-arrays with no `Entity` objects, no
+ * textures and no broadphase: a level holds a handful of colliders, so each
+ * instance tests its bird against all of them directly, in level order, as
+ * the game resolves its broadphase candidates. Hazard data that never
+ * changes (sizes, speeds, types, patrol routes) is shared by every instance;
+ * only positions, velocities and where each patrol is placed are kept per
+ * instance, instance-major.
+ *
+ * An instance whose episode ends is reset to a fresh spawn in the same
+ * `step()`, so the arrays always describe live episodes; `getOutcomes()`
+ * says which instances just finished and how.
+ *
+ * Instances only read their own slots, so disjoint ranges can be stepped on
+ * different threads at once (see `step(actions, deltaTime, begin, end)`).
+ */
+class VecEnv
+{
+private:
+    int mInstanceCount = 0;
+    int mHazardCount   = 0;
+
+    // The level's bird, shared by every instance
+    int     mBirdRecord = 0;   // its index among the level's entities
+    Vector2 mBirdSpawnMin;
+    Vector2 mBirdSpawnMax;
+    Vector2 mBirdDimensions;
+    float   mBirdGravity    = 0.0f;
+    float   mBirdBounciness = Entity::DEFAULT_BOUNCINESS;
+
+    // Everything else the level spawns, shared by every instance
+    std::vector<Vector2>       mHazardSpawnMin;
+    std::vector<Vector2>       mHazardSpawnMax;
+    std::vector<Vector2>       mHazardDimensions;
+    std::vector<Vector2>       mHazardSensorDimensions;   // zero if none
+    std::vector<float>         mHazardSpeeds;
+    std::vector<unsigned char> mHazardTypes;
+    PatrolRoutes               mRoutes;
+    // Each hazard's route, unplaced; its own if the level gives it one,
+    // otherwise from edge to edge as `EntityStore` gives every patrol
+    std::vector<PatrolPath>    mHazardRoutes;
+    std::vector<unsigned char> mHazardHasPath;
+    // Hazard `h` is candidate `h` of every bird, so contacts name it by that
+    std::vector<EntityHandle>  mHazardIndices;
+    int                        mSensorCount = 0;
+
+    // Per instance
+    std::vector<Vector2>       mPositions;
+    std::vector<Vector2>       mVelocities;
+    std::vector<float>         mAccelerationsX;
+    std::vector<int>           mFuel;
+    std::vector<float>         mFuelAccumulators;
+    std::vector<unsigned char> mOutcomes;
+    std::vector<int>           mEpisodeSteps;
+    std::vector<unsigned int>  mRandomStates;
+
+    // Per instance and hazard, at [instance * hazardCount + hazard]
+    std::vector<Vector2>       mHazardPositions;
+    std::vector<Vector2>       mHazardVelocities;
+    std::vector<PatrolPath>    mHazardPaths;
+
+    // Each instance's collision scratch for `StepBody()`, kept apart so
+    // instances stepped on different threads never share one
+    std::vector<float>         mXOverlaps;
+    std::vector<float>         mYOverlaps;
+    std::vector<unsigned int>  mHitMasks;
+    std::vector<Contact>       mContacts;
+    int                        mContactCapacity = 0;
+
+    void resetInstance(int instance);
+    void stepInstance(int instance, unsigned char action, float deltaTime);
+
+public:
+    VecEnv() { }
+
+    bool init(const Level &level, int instanceCount, unsigned int seed);
+    void reset();
+
+    void step(const unsigned char *actions, float deltaTime);
+    void step(const unsigned char *actions, float deltaTime, int begin,
+        int end);
+
+    int getInstanceCount() const { return mInstanceCount; }
+    int getHazardCount()   const { return mHazardCount;   }
+    EntityType getHazardType(int hazard) const
+        { return (EntityType) mHazardTypes[hazard]; }
+    Vector2 getHazardDimensions(int hazard) const
+        { return mHazardDimensions[hazard]; }
+    Vector2 getBirdDimensions() const { return mBirdDimensions; }
+
+    // Flat per-instance outputs, valid until the next `step()` or `reset()`
+    const Vector2       *getPositions()       const { return mPositions.data();       }
+    const Vector2       *getVelocities()      const { return mVelocities.data();      }
+    const int           *getFuel()            const { return mFuel.data();            }
+    const unsigned char *getOutcomes()        const { return mOutcomes.data();        }
+    const int           *getEpisodeSteps()    const { return mEpisodeSteps.data();    }
+    const Vector2       *getHazardPositions() const { return mHazardPositions.data(); }
+};
+
+#endif // VEC_ENV_H
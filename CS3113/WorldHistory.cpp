@@ -0,0 +1,203 @@
+#include "WorldHistory.h"
+#include <stdint.h>
+#include <string.h>
+
+constexpr int WorldSnapshot::MAX_ENTITIES;
+
+// Deltas are packed in whole 8-byte words: a `uint16_t` count of zero words,
+// a `uint16_t` count of literal words, then the literal words themselves
+static const int WORD_COUNT = (int) (sizeof(WorldSnapshot) / sizeof(uint64_t));
+static const int RUN_HEADER_SIZE = 2 * sizeof(uint16_t);
+
+static_assert(sizeof(WorldSnapshot) % sizeof(uint64_t) == 0,
+    "WorldSnapshot must be a whole number of words");
+static_assert(sizeof(WorldSnapshot) / sizeof(uint64_t) <= 0xFFFF,
+    "WorldSnapshot is too big for 16-bit run lengths");
+
+static inline uint64_t xorWord(const unsigned char *a, const unsigned char *b,
+    int word)
+{
+    uint64_t x, y;
+    memcpy(&x, a + word * sizeof(uint64_t), sizeof(uint64_t));
+    memcpy(&y, b + word * sizeof(uint64_t), sizeof(uint64_t));
+    return x ^ y;
+}
+
+/**
+ * Packs `a` XOR `b` into `out`, which must have room for
+ * `getMaxDeltaSize()` bytes.
+ *
+ * @return the packed size in bytes.
+ */
+static int packDelta(const WorldSnapshot &a, const WorldSnapshot &b,
+    unsigned char *out)
+{
+    const unsigned char *bytesA = (const unsigned char *) &a;
+    const unsigned char *bytesB = (const unsigned char *) &b;
+    int size = 0;
+    int word = 0;
+
+    while (word < WORD_COUNT)
+    {
+        uint16_t run[2] = { 0, 0 };
+        while (word < WORD_COUNT && xorWord(bytesA, bytesB, word) == 0)
+        {
+            run[0]++;
+            word++;
+        }
+
+        unsigned char *header = out + size;
+        size += RUN_HEADER_SIZE;
+
+        for (; word < WORD_COUNT; word++)
+        {
+            uint64_t value = xorWord(bytesA, bytesB, word);
+            if (value == 0) break;
+
+            memcpy(out + size, &value, sizeof(uint64_t));
+            size += sizeof(uint64_t);
+            run[1]++;
+        }
+
+        memcpy(header, run, RUN_HEADER_SIZE);
+    }
+
+    return size;
+}
+
+// XORs a delta packed by `packDelta()` into `snapshot`
+static void applyDelta(const unsigned char *delta, int size,
+    WorldSnapshot &snapshot)
+{
+    unsigned char *bytes = (unsigned char *) &snapshot;
+    int position = 0;
+    int word = 0;
+
+    while (position < size)
+    {
+        uint16_t run[2];
+        memcpy(run, delta + position, RUN_HEADER_SIZE);
+        position += RUN_HEADER_SIZE;
+        word += run[0];
+
+        for (int i = 0; i < run[1]; i++, word++)
+        {
+            uint64_t value, literal;
+            memcpy(&value, bytes + word * sizeof(uint64_t), sizeof(uint64_t));
+            memcpy(&literal, delta + position, sizeof(uint64_t));
+            value ^= literal;
+            memcpy(bytes + word * sizeof(uint64_t), &value, sizeof(uint64_t));
+            position += sizeof(uint64_t);
+        }
+    }
+}
+
+/**
+ * The most a packed delta can take: every other word differing, so each
+ * literal word gets a run header of its own.
+ */
+int WorldHistory::getMaxDeltaSize()
+{
+    return (WORD_COUNT + 1) * RUN_HEADER_SIZE +
+        WORD_COUNT * (int) sizeof(uint64_t);
+}
+
+/**
+ * Sizes every buffer up front and forgets any frames already stored.
+ *
+ * @param maxFrames how many steps back `rewind()` can go at most.
+ * @param byteCapacity room for packed deltas; raised to fit at least one
+ * worst-case delta. Older frames are dropped sooner if it runs out.
+ */
+void WorldHistory::init(int maxFrames, int byteCapacity)
+{
+    if (maxFrames < 1) maxFrames = 1;
+    if (byteCapacity < getMaxDeltaSize()) byteCapacity = getMaxDeltaSize();
+
+    mFrames.assign(maxFrames, { 0, 0 });
+    mBytes.assign(byteCapacity, 0);
+    mScratch.assign(getMaxDeltaSize(), 0);
+    clear();
+}
+
+void WorldHistory::clear()
+{
+    mLatest      = WorldSnapshot();
+    mHasLatest   = false;
+    mFirstFrame  = 0;
+    mFrameCount  = 0;
+    mWriteOffset = 0;
+}
+
+void WorldHistory::dropOldest()
+{
+    mFirstFrame = (mFirstFrame + 1) % (int) mFrames.size();
+    mFrameCount--;
+}
+
+/**
+ * Adds `snapshot` as the newest frame. The frame it replaces as the newest
+ * is kept as a delta against it.
+ */
+void WorldHistory::push(const WorldSnapshot &snapshot)
+{
+    if (mFrames.empty()) return;
+
+    if (!mHasLatest)
+    {
+        mLatest    = snapshot;
+        mHasLatest = true;
+        return;
+    }
+
+    int size     = packDelta(snapshot, mLatest, mScratch.data());
+    int capacity = (int) mBytes.size();
+
+    // Deltas are written one after another and wrap to the start when the
+    // next doesn't fit; anything left past the wrap point is from the lap
+    // before, so older than everything in front of it
+    if (mWriteOffset + size > capacity)
+    {
+        while (mFrameCount > 0 && getFrame(0).offset >= mWriteOffset)
+            dropOldest();
+        mWriteOffset = 0;
+    }
+
+    if (mFrameCount == (int) mFrames.size()) dropOldest();
+    while (mFrameCount > 0 && getFrame(0).offset < mWriteOffset + size &&
+           mWriteOffset < getFrame(0).offset + getFrame(0).size)
+        dropOldest();
+
+    memcpy(&mBytes[mWriteOffset], mScratch.data(), size);
+    mFrames[(mFirstFrame + mFrameCount) % (int) mFrames.size()] =
+        { mWriteOffset, size };
+    mFrameCount++;
+    mWriteOffset += size;
+    mLatest = snapshot;
+}
+
+/**
+ * Steps back one frame: the newest is dropped, and the one before it
+ * becomes the newest and is copied into `snapshot`.
+ *
+ * @return false if there is no older frame; `snapshot` is untouched then.
+ */
+bool WorldHistory::rewind(WorldSnapshot &snapshot)
+{
+    if (mFrameCount == 0) return false;
+
+    const Frame &newest = getFrame(mFrameCount - 1);
+    applyDelta(&mBytes[newest.offset], newest.size, mLatest);
+    mWriteOffset = newest.offset;
+    mFrameCount--;
+
+    snapshot = mLatest;
+    return true;
+}
+
+int WorldHistory::getBytesUsed() const
+{
+    int total = 0;
+    for (int i = 0; i < mFrameCount; i++) total += getFrame(i).size;
+    return total;
+}
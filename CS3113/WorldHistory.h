@@ -0,0 +1,66 @@
+#ifndef WORLD_HISTORY_H
+#define WORLD_HISTORY_H
+
+#include "WorldSnapshot.h"
+
+/**
+ * The last few seconds of a simulation, one `WorldSnapshot` per step, for
+ * rewinding and rolling back. Only the newest frame is kept whole; every
+ * older one is stored as the XOR of it with the frame after it, so stepping
+ * back is XORing the newest delta into the newest frame.
+ *
+ * Consecutive steps differ in a few fields, so most of a delta is zero. Each
+ * is packed as runs of zero words and runs of literal words into one ring
+ * of bytes, and usually costs a few hundred bytes rather than the whole
+ * snapshot. When the ring or the frame limit fills up the oldest deltas are
+ * dropped.
+ *
+ * Every buffer is sized by `init()`, so `push()` and `rewind()` never
+ * allocate.
+ */
+class WorldHistory
+{
+private:
+    // Where one frame's delta sits in mBytes
+    struct Frame
+    {
+        int offset;
+        int size;
+    };
+
+    WorldSnapshot              mLatest = WorldSnapshot();
+    bool                       mHasLatest = false;
+    std::vector<Frame>         mFrames;   // ring, oldest at mFirstFrame
+    int                        mFirstFrame = 0;
+    int                        mFrameCount = 0;
+    std::vector<unsigned char> mBytes;    // ring of packed deltas
+    int                        mWriteOffset = 0;
+    std::vector<unsigned char> mScratch;  // one packed delta, worst case
+
+    const Frame &getFrame(int index) const
+        { return mFrames[(mFirstFrame + index) % (int) mFrames.size()]; }
+    void dropOldest();
+
+public:
+    WorldHistory() { }
+
+    WorldHistory(const WorldHistory &) = delete;
+    WorldHistory &operator=(const WorldHistory &) = delete;
+
+    static int getMaxDeltaSize();
+
+    void init(int maxFrames, int byteCapacity);
+    void clear();
+
+    void push(const WorldSnapshot &snapshot);
+    bool rewind(WorldSnapshot &snapshot);
+
+    // Steps `rewind()` can go back
+    int getFrameCount() const { return mFrameCount; }
+    // Bytes the stored deltas take up
+    int getBytesUsed() const;
+    // The frame pushed last, or where the last `rewind()` went back to
+    const WorldSnapshot &getLatest() const { return mLatest; }
+};
+
+#endif // WORLD_HISTORY_H
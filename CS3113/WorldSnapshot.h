@@ -0,0 +1,55 @@
+#ifndef WORLD_SNAPSHOT_H
+#define WORLD_SNAPSHOT_H
+
+#include "cs3113.h"
+#include <type_traits>
+
+// What a fixed step can change on one `Entity` outside the store, taken by
+// `Entity::saveState()`
+struct EntityState
+{
+    Vector2       movement;
+    float         animationTime;
+    int           frameIndex;
+    int           fuel;
+    unsigned char direction;
+    bool          isJumping;
+};
+
+/**
+ * Everything a fixed step changes, as plain data with no pointers, so a
+ * moment of the simulation is saved, restored or compared with `memcpy()`
+ * and `memcmp()` and never allocates. What stays fixed once a level is
+ * spawned (sizes, sensors, patrol speeds, types, textures) is left out, so a
+ * snapshot only restores into the level it was taken from.
+ *
+ * The capacity is fixed so every snapshot is the same size and can be
+ * delta-compressed against any other (see `WorldHistory`). Unused slots and
+ * padding are left as they were, so start from a value-initialised
+ * (all-zero) snapshot to keep them out of the deltas.
+ */
+struct WorldSnapshot
+{
+    static constexpr int MAX_ENTITIES = 64;
+
+    unsigned long long stepCount;
+    int                entityCount;
+    int                gameState;
+    float              fuelAccumulator;
+    unsigned int       randomState;
+
+    // By handle, as `EntityStore::save()` copies them
+    Vector2       positions[MAX_ENTITIES];
+    Vector2       previousPositions[MAX_ENTITIES];
+    Vector2       velocities[MAX_ENTITIES];
+    Vector2       accelerations[MAX_ENTITIES];
+    unsigned char flags[MAX_ENTITIES];
+
+    // In the order of the entity list it was saved from
+    EntityState   entities[MAX_ENTITIES];
+};
+
+static_assert(std::is_trivially_copyable<WorldSnapshot>::value,
+    "WorldSnapshot must stay plain data");
+
+#endif // WORLD_SNAPSHOT_H
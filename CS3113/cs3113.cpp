@@ -1,5 +1,7 @@
 #include "cs3113.h"
 
+static unsigned int gRandomState = 1;
+
 Color ColorFromHex(const char *hex)
 {
     // Skip leading '#', if present
@@ -99,4 +101,68 @@ Rectangle getUVRectangle(const Texture2D *texture, int index, int rows, int cols
         sliceWidth, // width of slice
         sliceHeight // height of slice
     };
+}
+
+/**
+ * @brief Same as above, but slices a sub-region of a texture, such as a sprite
+ * sheet that was packed into a larger atlas.
+ * 
+ * @param region the part of the texture holding the sprite sheet.
+ */
+Rectangle getUVRectangle(Rectangle region, int index, int rows, int cols)
+{
+    float sliceWidth  = region.width  / (float) cols;
+    float sliceHeight = region.height / (float) rows;
+
+    return {
+        region.x + (index % cols) * sliceWidth,  // top-left x-coord
+        region.y + (index / cols) * sliceHeight, // top-left y-coord
+        sliceWidth,                              // width of slice
+        sliceHeight                              // height of slice
+    };
+}
+
+/**
+ * @brief Seeds the generator behind `RandomInt()`. Unlike raylib's
+ * `GetRandomValue()` this needs no window, and the same seed always yields the
+ * same sequence on every platform.
+ * 
+ * @param seed any value; zero is remapped since xorshift cannot leave it.
+ */
+void SeedRandom(unsigned int seed)
+{
+    gRandomState = seed != 0 ? seed : 0x9E3779B9u;
+}
+
+/**
+ * @brief The generator's current state: passing it back to `SeedRandom()`
+ * resumes the sequence from exactly this point.
+ */
+unsigned int GetRandomState()
+{
+    return gRandomState;
+}
+
+/**
+ * @brief Returns a pseudo-random integer in the inclusive range [min, max],
+ * drawn from a 32-bit xorshift generator.
+ */
+int RandomInt(int min, int max)
+{
+    return RandomInt(gRandomState, min, max);
+}
+
+/**
+ * @brief Same draw as `RandomInt(min, max)`, but from a generator whose
+ * state the caller keeps, so independent simulations can each have their
+ * own sequence. `state` must not be zero.
+ */
+int RandomInt(unsigned int &state, int min, int max)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    unsigned int range = (unsigned int) (max - min) + 1u;
+    return min + (int) (state % range);
 }
\ No newline at end of file
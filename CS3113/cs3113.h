@@ -2,9 +2,29 @@
 #define CS3113_H
 #define LOG(argument) std::cout << argument << '\n'
 
+// Times the rest of the enclosing scope under a `ProfilePhase` (Profiler.h),
+// or records a duration measured some other way with PROFILE_SAMPLE().
+// Compiled out entirely unless the build defines ENABLE_PROFILER.
+#ifdef ENABLE_PROFILER
+#define PROFILE_JOIN_(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_(a, b)
+#define PROFILE(phase) ProfileScope PROFILE_JOIN(profileScope, __LINE__)(phase)
+#define PROFILE_SAMPLE(phase, nanoseconds) \
+    Profiler::shared().record(phase, nanoseconds)
+#define PROFILE_NEXT_FRAME() Profiler::shared().nextFrame()
+#else
+#define PROFILE(phase)
+#define PROFILE_SAMPLE(phase, nanoseconds)
+#define PROFILE_NEXT_FRAME()
+#endif
+
+#ifndef HEADLESS
 #include "raylib.h"
 #include "rlgl.h"
 #include "raymath.h"
+#else
+#include "HeadlessRaylib.h"
+#endif
 #include <math.h>
 #include <time.h>
 #include <stdio.h>
@@ -16,9 +36,25 @@
 enum AppStatus   { TERMINATED, RUNNING };
 enum TextureType { SINGLE, ATLAS       };
 
+// One bit per player action sampled for a simulation step
+enum InputFlag
+{
+    INPUT_JUMP  = 1 << 0,
+    INPUT_LEFT  = 1 << 1,
+    INPUT_RIGHT = 1 << 2,
+    INPUT_QUIT  = 1 << 3,
+    // Held to play the world's history backwards instead of stepping
+    INPUT_REWIND = 1 << 4
+};
+
 Color ColorFromHex(const char *hex);
 void Normalise(Vector2 *vector);
 float GetLength(const Vector2 vector);
 Rectangle getUVRectangle(const Texture2D *texture, int index, int rows, int cols);
+Rectangle getUVRectangle(Rectangle region, int index, int rows, int cols);
+void SeedRandom(unsigned int seed);
+unsigned int GetRandomState();
+int RandomInt(int min, int max);
+int RandomInt(unsigned int &state, int min, int max);
 
 #endif // CS3113_H
\ No newline at end of file
@@ -0,0 +1,550 @@
+/**
+ * Microbenchmarks for the per-step hot paths. Runs headless (built with
+ * -DHEADLESS, no window or textures) and reports ns/op, heap allocations per
+ * op and, where the kernel allows it, cache misses per op.
+ *
+ * Usage: ./bench_app [--json <file>] [--compare <baseline.json>]
+ *                    [--threshold <percent>] [--filter <name>]
+ *
+ * `parallel_update_tN` runs the snapshot-based `Entity::updateParallel()`
+ * with N threads; comparing them shows how the update scales with cores.
+ *
+ * Results are written as JSON (bench_results.json by default). With
+ * `--compare`, every benchmark that got slower than the baseline by more than
+ * the threshold is flagged and the exit status is 1.
+ */
+#include "../CS3113/Entity.h"
+#include "../CS3113/SpatialHash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Global Constants
+constexpr int SCENE_SIZES[] = {1, 100, 10000, 100000};
+// Thread counts for the parallel update scaling runs, which only use scenes
+// of at least MIN_SCALING_SCENE entities
+constexpr int THREAD_COUNTS[] = {1, 2, 4, 8};
+constexpr int MIN_SCALING_SCENE = 10000;
+constexpr float STEP = 1.0f / 120.0f;
+constexpr double MIN_SECONDS = 0.1;
+constexpr int MIN_PASSES = 3;
+// Small scenes repeat their pass inside one timed block until it covers at
+// least this many entities, so clock overhead doesn't swamp the result
+constexpr int MIN_BLOCK_SIZE = 1000;
+constexpr float WORLD_AREA_PER_ENTITY = 96.0f * 96.0f;
+constexpr float DEFAULT_THRESHOLD = 10.0f;
+constexpr char DEFAULT_JSON_FP[] = "bench_results.json";
+constexpr char BIRD_FP[] = "assets/owl.png";
+
+// Allocation counting: every global operator new in the process goes
+// through here
+std::atomic<unsigned long long> gAllocationCount{0};
+
+// Both kept out of line so GCC doesn't see malloc()/free() behind them and
+// warn about mismatched allocation functions
+__attribute__((noinline)) void *operator new(size_t size) {
+  gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void *memory = malloc(size ? size : 1))
+    return memory;
+  throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void *memory) noexcept {
+  free(memory);
+}
+void operator delete(void *memory, size_t) noexcept {
+  operator delete(memory);
+}
+
+JobSystem gJobSystem(0);
+
+// Keeps results alive so the optimiser can't drop the work being timed
+volatile float gSink = 0.0f;
+
+/**
+ * @brief Hardware cache-miss counter for the calling thread, via
+ * perf_event_open on Linux. `isAvailable()` is false anywhere else, or when
+ * the kernel doesn't allow unprivileged counters.
+ */
+class CacheMissCounter {
+private:
+  int mDescriptor = -1;
+
+public:
+  CacheMissCounter() {
+#ifdef __linux__
+    perf_event_attr attributes;
+    memset(&attributes, 0, sizeof(attributes));
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    mDescriptor =
+        (int)syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0);
+#endif
+  }
+  ~CacheMissCounter() {
+#ifdef __linux__
+    if (mDescriptor >= 0)
+      close(mDescriptor);
+#endif
+  }
+
+  bool isAvailable() const { return mDescriptor >= 0; }
+
+  void start() {
+#ifdef __linux__
+    if (mDescriptor >= 0) {
+      ioctl(mDescriptor, PERF_EVENT_IOC_RESET, 0);
+      ioctl(mDescriptor, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  unsigned long long stop() {
+    unsigned long long count = 0;
+#ifdef __linux__
+    if (mDescriptor >= 0) {
+      ioctl(mDescriptor, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(mDescriptor, &count, sizeof(count)) != sizeof(count))
+        count = 0;
+    }
+#endif
+    return count;
+  }
+};
+
+/**
+ * @brief A store full of animated, colliding entities scattered over a world
+ * that grows with the entity count, so density (and therefore candidates per
+ * entity) stays the same from 100 to 100k entities. Broadphase candidates are
+ * gathered once up front; `restore()` puts every entity back where it
+ * started so each timed pass does the same work.
+ */
+struct Scene {
+  EntityStore store;
+  std::vector<Entity *> entities;
+  std::vector<int> candidateStart;
+  std::vector<EntityHandle> candidates;
+  // Each entity's closest candidate, or the next entity if it has none. At
+  // this density about half of them overlap, so `isColliding()` takes both
+  // of its paths
+  std::vector<EntityHandle> collisionPartners;
+  // Collision scratch for one pass, reset at the start of the next
+  Arena frameArena;
+
+  std::vector<Vector2> initialPositions;
+  std::vector<Vector2> initialVelocities;
+
+  // A second store of bare colliders, a random mix of players, platforms and
+  // enemies, for the patrol system. The patrols are an even mix of the
+  // default edge-to-edge route, loops and splines
+  EntityStore patrolStore;
+  std::vector<Vector2> initialPatrolPositions;
+  std::vector<unsigned char> initialPatrolFlags;
+  double patrolTime = 0.0;
+
+  explicit Scene(int count) {
+    float side = sqrtf(WORLD_AREA_PER_ENTITY * count);
+    std::map<Direction, std::vector<int>> animationAtlas{
+        {DOWN, {0, 1, 2, 3, 4, 5}},
+        {UP, {0, 1, 2, 3, 4, 5}},
+        {LEFT, {0, 1, 2, 3, 4, 5}},
+        {RIGHT, {0, 1, 2, 3, 4, 5}}};
+
+    SeedRandom(1);
+    store.reserve(count);
+    for (int i = 0; i < count; i++) {
+      Vector2 position = {(float)RandomInt(0, (int)side),
+                          (float)RandomInt(0, (int)side)};
+      Entity *entity =
+          new Entity(&store, position, {40.0f, 40.0f}, BIRD_FP, ATLAS,
+                     {6, 9}, animationAtlas, PLAYER);
+      entity->setFrameSpeed(6);
+      entity->setVelocity({(float)RandomInt(-100, 100), 0.0f});
+      entities.push_back(entity);
+    }
+
+    SpatialHash grid(SpatialHash::DEFAULT_CELL_SIZE, {0, 0, side, side});
+    grid.rebuild(store);
+
+    std::vector<EntityHandle> results;
+    for (Entity *entity : entities) {
+      candidateStart.push_back((int)candidates.size());
+      int found = grid.queryRegion(entity->getPosition(),
+                                   entity->getBroadphaseDimensions(STEP),
+                                   results, entity->getHandle());
+      candidates.insert(candidates.end(), results.begin(),
+                        results.begin() + found);
+    }
+    candidateStart.push_back((int)candidates.size());
+
+    for (int i = 0; i < count; i++) {
+      Vector2 position = entities[i]->getPosition();
+      EntityHandle partner = entities[(i + 1) % count]->getHandle();
+      float closest = INFINITY;
+      for (int c = candidateStart[i]; c < candidateStart[i + 1]; c++) {
+        Vector2 other = store.positions[candidates[c]];
+        float distance = fmaxf(fabsf(other.x - position.x),
+                               fabsf(other.y - position.y));
+        if (distance < closest) {
+          closest = distance;
+          partner = candidates[c];
+        }
+      }
+      collisionPartners.push_back(partner);
+    }
+
+    initialPositions = store.positions;
+    initialVelocities = store.velocities;
+
+    const EntityType patrolTypes[] = {PLAYER, PLATFORM, ENEMY};
+    const Vector2 waypoints[] = {
+        {0.0f, 0.0f}, {120.0f, -40.0f}, {200.0f, 60.0f}, {60.0f, 120.0f}};
+    patrolStore.reserve(count);
+    for (int i = 0; i < count; i++) {
+      Vector2 position = {(float)RandomInt(0, SCREEN_WIDTH),
+                          (float)RandomInt(0, SCREEN_HEIGHT)};
+      EntityHandle handle = patrolStore.create(position, {80.0f, 50.0f},
+                                               patrolTypes[RandomInt(0, 2)]);
+      patrolStore.platformSpeeds[handle] = (float)RandomInt(1, 5);
+      if (i % 3 != 0)
+        patrolStore.setPatrolPath(handle,
+                                  i % 3 == 1 ? PATROL_LOOP : PATROL_SPLINE,
+                                  waypoints, 4);
+    }
+    initialPatrolPositions = patrolStore.positions;
+    initialPatrolFlags = patrolStore.flags;
+  }
+
+  ~Scene() {
+    for (Entity *entity : entities)
+      delete entity;
+  }
+
+  void restore() {
+    std::copy(initialPositions.begin(), initialPositions.end(),
+              store.positions.begin());
+    std::copy(initialVelocities.begin(), initialVelocities.end(),
+              store.velocities.begin());
+    std::copy(initialPatrolPositions.begin(), initialPatrolPositions.end(),
+              patrolStore.positions.begin());
+    std::copy(initialPatrolFlags.begin(), initialPatrolFlags.end(),
+              patrolStore.flags.begin());
+    patrolTime = 0.0;
+  }
+};
+
+// One timed pass over a working set of `count` items; returns how many
+// operations it performed
+typedef long long (*BenchmarkPass)(Scene &scene, int count);
+
+// Physics then animation, each as its own system over the whole scene
+long long benchEntityUpdate(Scene &scene, int count) {
+  scene.frameArena.reset();
+  for (int i = 0; i < count; i++) {
+    int start = scene.candidateStart[i];
+    scene.entities[i]->update(STEP, scene.candidates.data() + start,
+                              scene.candidateStart[i + 1] - start,
+                              scene.frameArena);
+  }
+  Entity::animateAll(scene.entities.data(), count, STEP);
+  return count;
+}
+
+long long benchIsColliding(Scene &scene, int count) {
+  int hits = 0;
+  for (int i = 0; i < count; i++)
+    hits += scene.entities[i]->isColliding(scene.collisionPartners[i]);
+  gSink = gSink + hits;
+  return count;
+}
+
+long long benchParallelUpdate(Scene &scene, int count) {
+  scene.frameArena.reset();
+  scene.store.takeSnapshot();
+  Entity::updateParallel(gJobSystem, scene.entities.data(), count,
+                         scene.candidateStart.data(), scene.candidates.data(),
+                         STEP, scene.frameArena);
+  scene.store.releaseSnapshot();
+  return count;
+}
+
+long long benchPatrolUpdate(Scene &scene, int count) {
+  scene.patrolTime += STEP;
+  scene.patrolStore.updatePatrols(scene.patrolTime);
+  return count;
+}
+
+long long benchAnimate(Scene &scene, int count) {
+  for (int i = 0; i < count; i++)
+    scene.entities[i]->animate(STEP);
+  return count;
+}
+
+long long benchGetUVRectangle(Scene &, int count) {
+  Rectangle region = {0.0f, 0.0f, 384.0f, 576.0f};
+  float total = 0.0f;
+  for (int i = 0; i < count; i++) {
+    Rectangle uv = getUVRectangle(region, i % 54, 9, 6);
+    total += uv.x + uv.y;
+  }
+  gSink = gSink + total;
+  return count;
+}
+
+long long benchGetLength(Scene &scene, int count) {
+  const Vector2 *velocities = scene.store.velocities.data();
+  float total = 0.0f;
+  for (int i = 0; i < count; i++)
+    total += GetLength(velocities[i]);
+  gSink = gSink + total;
+  return count;
+}
+
+long long benchNormalise(Scene &scene, int count) {
+  Vector2 *positions = scene.store.positions.data();
+  for (int i = 0; i < count; i++)
+    Normalise(&positions[i]);
+  return count;
+}
+
+struct Benchmark {
+  const char *name;
+  BenchmarkPass pass;
+};
+
+const Benchmark BENCHMARKS[] = {
+    {"entity_update", benchEntityUpdate},
+    {"entity_is_colliding", benchIsColliding},
+    {"entity_animate", benchAnimate},
+    {"patrol_update", benchPatrolUpdate},
+    {"get_uv_rectangle", benchGetUVRectangle},
+    {"get_length", benchGetLength},
+    {"normalise", benchNormalise}};
+
+struct Result {
+  std::string name;
+  int entities;
+  long long operations;
+  double nsPerOp;
+  double allocationsPerOp;
+  double cacheMissesPerOp; // negative when unavailable
+};
+
+/**
+ * @brief Runs `benchmark` on `scene` for at least `MIN_PASSES` timed blocks
+ * and `MIN_SECONDS` of timed work, after one untimed warm-up pass. The scene
+ * is restored before every block.
+ */
+Result runBenchmark(const Benchmark &benchmark, Scene &scene,
+                    CacheMissCounter &cacheMisses) {
+  int count = (int)scene.entities.size();
+  int repeats = std::max(1, MIN_BLOCK_SIZE / count);
+  scene.restore();
+  benchmark.pass(scene, count);
+
+  long long operations = 0;
+  unsigned long long allocations = 0, misses = 0;
+  double seconds = 0.0;
+
+  for (int passes = 0; passes < MIN_PASSES || seconds < MIN_SECONDS;
+       passes++) {
+    scene.restore();
+
+    unsigned long long allocationsBefore = gAllocationCount.load();
+    cacheMisses.start();
+    auto start = std::chrono::steady_clock::now();
+
+    for (int r = 0; r < repeats; r++)
+      operations += benchmark.pass(scene, count);
+
+    seconds += std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start).count();
+    misses += cacheMisses.stop();
+    allocations += gAllocationCount.load() - allocationsBefore;
+  }
+
+  Result result;
+  result.name = benchmark.name;
+  result.entities = count;
+  result.operations = operations;
+  result.nsPerOp = seconds * 1e9 / operations;
+  result.allocationsPerOp = (double)allocations / operations;
+  result.cacheMissesPerOp =
+      cacheMisses.isAvailable() ? (double)misses / operations : -1.0;
+  return result;
+}
+
+void printResult(const Result &result) {
+  char misses[32] = "-";
+  if (result.cacheMissesPerOp >= 0.0)
+    snprintf(misses, sizeof(misses), "%.3f", result.cacheMissesPerOp);
+  printf("%-22s %9d %12.2f %10.3f %12s\n", result.name.c_str(),
+         result.entities, result.nsPerOp, result.allocationsPerOp, misses);
+  fflush(stdout);
+}
+
+bool writeJSON(const char *filepath, const std::vector<Result> &results) {
+  FILE *file = fopen(filepath, "w");
+  if (!file)
+    return false;
+
+  fprintf(file, "{\n  \"benchmarks\": [\n");
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &result = results[i];
+    char misses[32] = "null";
+    if (result.cacheMissesPerOp >= 0.0)
+      snprintf(misses, sizeof(misses), "%.4f", result.cacheMissesPerOp);
+
+    // One benchmark per line, which `readBaseline()` relies on
+    fprintf(file,
+            "    {\"name\": \"%s\", \"entities\": %d, \"operations\": %lld, "
+            "\"ns_per_op\": %.3f, \"allocs_per_op\": %.4f, "
+            "\"cache_misses_per_op\": %s}%s\n",
+            result.name.c_str(), result.entities, result.operations,
+            result.nsPerOp, result.allocationsPerOp, misses,
+            i + 1 < results.size() ? "," : "");
+  }
+  fprintf(file, "  ]\n}\n");
+
+  bool ok = !ferror(file);
+  return fclose(file) == 0 && ok;
+}
+
+/**
+ * @brief Reads ns/op per "name/entities" key from a file written by
+ * `writeJSON()`.
+ */
+bool readBaseline(const char *filepath, std::map<std::string, double> &baseline) {
+  FILE *file = fopen(filepath, "r");
+  if (!file)
+    return false;
+
+  char line[512];
+  while (fgets(line, sizeof(line), file)) {
+    char name[128];
+    int entities;
+    double nsPerOp;
+    const char *entry = strstr(line, "{\"name\"");
+    if (entry && sscanf(entry,
+                        "{\"name\": \"%127[^\"]\", \"entities\": %d, "
+                        "\"operations\": %*d, \"ns_per_op\": %lf",
+                        name, &entities, &nsPerOp) == 3)
+      baseline[std::string(name) + "/" + std::to_string(entities)] = nsPerOp;
+  }
+  fclose(file);
+  return true;
+}
+
+int main(int argc, char *argv[]) {
+  const char *jsonPath = DEFAULT_JSON_FP;
+  const char *baselinePath = nullptr;
+  const char *filter = nullptr;
+  float threshold = DEFAULT_THRESHOLD;
+
+  for (int i = 1; i < argc; i++) {
+    std::string argument = argv[i];
+    if (argument == "--json" && i + 1 < argc)
+      jsonPath = argv[++i];
+    else if (argument == "--compare" && i + 1 < argc)
+      baselinePath = argv[++i];
+    else if (argument == "--threshold" && i + 1 < argc)
+      threshold = (float)atof(argv[++i]);
+    else if (argument == "--filter" && i + 1 < argc)
+      filter = argv[++i];
+    else {
+      LOG("Unknown argument " << argument);
+      return 2;
+    }
+  }
+
+  CacheMissCounter cacheMisses;
+  if (!cacheMisses.isAvailable())
+    LOG("Cache-miss counters unavailable; reporting them as null");
+
+  printf("%-22s %9s %12s %10s %12s\n", "benchmark", "entities", "ns/op",
+         "allocs/op", "misses/op");
+
+  std::vector<Result> results;
+  for (int size : SCENE_SIZES) {
+    Scene scene(size);
+
+    for (const Benchmark &benchmark : BENCHMARKS) {
+      if (filter && !strstr(benchmark.name, filter))
+        continue;
+
+      Result result = runBenchmark(benchmark, scene, cacheMisses);
+      results.push_back(result);
+      printResult(result);
+    }
+
+    if (size < MIN_SCALING_SCENE)
+      continue;
+
+    double singleThreadNs = 0.0;
+    for (int threads : THREAD_COUNTS) {
+      std::string name = "parallel_update_t" + std::to_string(threads);
+      if (filter && !strstr(name.c_str(), filter))
+        continue;
+
+      gJobSystem.setWorkerCount(threads - 1);
+      Benchmark benchmark = {name.c_str(), benchParallelUpdate};
+      Result result = runBenchmark(benchmark, scene, cacheMisses);
+      results.push_back(result);
+      printResult(result);
+
+      if (threads == 1)
+        singleThreadNs = result.nsPerOp;
+      else if (singleThreadNs > 0.0)
+        printf("%-22s %9s %11.2fx speedup over 1 thread\n", "", "",
+               singleThreadNs / result.nsPerOp);
+    }
+    gJobSystem.setWorkerCount(0);
+  }
+
+  if (writeJSON(jsonPath, results))
+    LOG("Wrote " << jsonPath);
+  else
+    LOG("Could not write " << jsonPath);
+
+  if (!baselinePath)
+    return 0;
+
+  std::map<std::string, double> baseline;
+  if (!readBaseline(baselinePath, baseline)) {
+    LOG("Could not read baseline " << baselinePath);
+    return 2;
+  }
+
+  int regressions = 0;
+  for (const Result &result : results) {
+    std::string key = result.name + "/" + std::to_string(result.entities);
+    auto entry = baseline.find(key);
+    if (entry == baseline.end() || entry->second <= 0.0)
+      continue;
+
+    double change = (result.nsPerOp / entry->second - 1.0) * 100.0;
+    if (change > threshold) {
+      printf("REGRESSION %-30s %10.2f -> %10.2f ns/op (%+.1f%%)\n",
+             key.c_str(), entry->second, result.nsPerOp, change);
+      regressions++;
+    }
+  }
+
+  LOG(regressions << " regression(s) beyond " << threshold << "% against "
+                  << baselinePath);
+  return regressions > 0 ? 1 : 0;
+}
@@ -1,11 +1,53 @@
+#include "CS3113/Arena.h"
+#include "CS3113/AssetLoader.h"
+#include "CS3113/BirdRules.h"
+#include "CS3113/CachedLayer.h"
+#include "CS3113/DrawCallCounter.h"
 #include "CS3113/Entity.h"
+#include "CS3113/FixedTimestep.h"
+#include "CS3113/InputQueue.h"
+#include "CS3113/InputRecording.h"
+#include "CS3113/JobSystem.h"
+#include "CS3113/Level.h"
+#include "CS3113/Pool.h"
+#include "CS3113/Profiler.h"
+#include "CS3113/RenderSnapshot.h"
+#include "CS3113/SpatialHash.h"
+#include "CS3113/SpriteBatch.h"
+#include "CS3113/TripleBuffer.h"
+#include "CS3113/VecEnv.h"
+#include "CS3113/WorldHistory.h"
 #include "CS3113/cs3113.h"
 #include "CS3113/constants.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <thread>
+
 // Forward declarations
 void initialise();
+void loadAssets();
+void renderLoadingFrame(int loaded, int total);
+void loadLayers();
+void updateHudLayers(const RenderSnapshot &snapshot);
 void processInput();
-void update();
+unsigned char pollInput();
+unsigned char autopilotInput();
+unsigned char nextStepInput(std::chrono::steady_clock::time_point stepTime);
+void applyInput(unsigned char input, float frameTime);
+void simulate();
+std::chrono::steady_clock::time_point
+stepDueTime(std::chrono::steady_clock::time_point now, int stepsBefore);
+int update(float frameTime, std::chrono::steady_clock::time_point now);
+void step(float deltaTime);
+void advanceWorld(unsigned char input, float deltaTime);
+void saveWorld(WorldSnapshot &snapshot);
+bool restoreWorld(const WorldSnapshot &snapshot);
+void captureSnapshot(RenderSnapshot &snapshot, unsigned long long stepCount,
+                     std::chrono::steady_clock::time_point stepTime);
 void render();
 void shutdown();
 bool isColliding(const Vector2 *postionA, const Vector2 *scaleA,
@@ -15,14 +57,36 @@ void renderObject(const Texture2D *texture, const Vector2 *position,
 
 // Global Constants
 constexpr int FPS = 60, SPEED = 200, SHRINK_RATE = 100;
+constexpr float PHYSICS_HZ = 120.0f;
+constexpr int MAX_CATCH_UP_STEPS = 8;
+constexpr int FAST_REPLAY_STEPS_PER_FRAME = 64;
+// Phase 1 work items (patrols, then animations) per job: each is a few
+// nanoseconds, so smaller chunks would cost more to hand out than to run
+constexpr int PHASE_ONE_GRAIN_SIZE = 256;
+constexpr int VEC_ENV_GRAIN_SIZE = 256;
+constexpr int HUD_FONT_SIZE = 20, BANNER_FONT_SIZE = 40;
+// How far back holding rewind can go, and the room its deltas get
+constexpr int HISTORY_SECONDS = 10;
+constexpr int HISTORY_BYTES = 1 << 20;
 
 Vector2 ORIGIN = {SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2},
         BIRD_BASE_SIZE = {40.0f, 40.0f}, BEAKER_BASE_SIZE = {250.0f, 250.0f};
 // File paths for textures
-constexpr char BIRD_FP[] = "assets/owl.png";
 constexpr char BACKGROUND_FP[] = "assets/background.png";
-constexpr char NEST_FP[] = "assets/nest.png";
-constexpr char ENEMY_FP[] = "assets/evil_hawk.png";
+// Compiled from levels/level1.txt by `make levels`
+constexpr char DEFAULT_LEVEL_FP[] = "levels/level1.lvl";
+// Profiler exports, written on shutdown when built with PROFILE=1
+constexpr char PROFILE_CSV_FP[] = "profile.csv";
+constexpr char PROFILE_JSON_FP[] = "profile.json";
+
+// Draw order for the sprite batch, back to front. The background itself is
+// a cached layer composited underneath all of them
+enum RenderLayer {
+    LAYER_BACKGROUND,
+    LAYER_PLATFORMS,
+    LAYER_ENEMIES,
+    LAYER_PLAYER
+};
 
 enum GameState {
     PLAYING,
@@ -31,18 +95,111 @@ enum GameState {
 };
 
 // Global Variables
-AppStatus gAppStatus = RUNNING;
-float gAngle = 0.0f, gPreviousTicks = 0.0f;
-float gDeltaTime = 0.0f;
+// Set by whichever thread sees the quit first; both loops watch it
+std::atomic<AppStatus> gAppStatus{RUNNING};
+float gAngle = 0.0f;
 float gFuelAccumulator = 0.0f;
 GameState gameState = PLAYING;
+// Fixed steps run since the level was spawned
+unsigned long long gStepCount = 0;
+FixedTimestep gTimestep(PHYSICS_HZ, MAX_CATCH_UP_STEPS);
 
+EntityStore gEntityStore;
 Entity *bird_entity = nullptr;
 Texture2D background;
+Rectangle backgroundRegion;
+SpriteBatch gSpriteBatch;
+// Draw calls rlgl actually submitted last frame, for the F1 overlay
+DrawCallCounter gDrawCalls;
+// Layers render() composites: the background is drawn into its layer once,
+// the fuel readout and win/lose banner whenever what they show changes
+CachedLayer gBackgroundLayer, gFuelLayer, gBannerLayer;
+bool gShowColliders = false;
+bool gShowProfiler = false;
 Entity *nest_platform = nullptr;
-Entity *hawk_enemy_1 = nullptr;
-Entity *hawk_enemy_2 = nullptr;
-Entity *collidable[3];
+// Everything the level spawned, the bird and nest included. The entities
+// live in a pool carved out of the level arena; both are emptied on
+// shutdown()
+std::vector<Entity *> gEntities;
+// The animated (`ATLAS`) ones among them, for the animation system
+std::vector<Entity *> gAnimatedEntities;
+Arena gLevelArena;
+Pool<Entity> gEntityPool;
+Level gLevel;
+const char *gLevelPath = DEFAULT_LEVEL_FP;
+SpatialHash gSpatialHash;
+std::vector<EntityHandle> gCandidates;
+// Scratch for one simulation step (collision lists), reset as each starts
+Arena gFrameArena;
+// Every step's world, for rewinding (INPUT_REWIND) and rollback, and the
+// snapshot each is saved into on its way there
+WorldHistory gHistory;
+WorldSnapshot gWorld = WorldSnapshot();
+// False when the level has more entities than a snapshot holds; nothing is
+// saved then and INPUT_REWIND does nothing
+bool gHistoryEnabled = true;
+// Workers are started in main() once --workers has been read
+JobSystem gJobSystem(0);
+int gWorkerCount = -1;
+
+// Startup: images decode in the background while a loading frame is shown,
+// and the time until each kind of frame is reported
+AssetLoader gAssetLoader;
+std::chrono::steady_clock::time_point gLaunchTime;
+bool gHasShownFirstFrame = false;
+
+// Input recording and replay (--record / --replay)
+InputRecording gRecording;
+bool gIsRecording = false, gIsReplaying = false, gFastReplay = false;
+const char *gRecordingPath = nullptr;
+// Keyboard changes on their way from the render thread to the simulation,
+// each stamped with when processInput() saw it and applied by the first
+// fixed step due after that
+InputQueue gInputQueue;
+// Render thread: the held keys last queued, and presses a full queue
+// couldn't take yet
+unsigned char gQueuedHeld = 0, gPendingPresses = 0;
+// Simulation thread: the held keys as of the current step, and presses
+// waiting for the next one
+unsigned char gStepHeld = 0, gStepPresses = 0;
+
+// The windowed game simulates on its own thread (see simulate()) and hands
+// each batch of steps to render() as a snapshot
+std::thread gSimulationThread;
+TripleBuffer<RenderSnapshot> gSnapshots;
+
+#ifdef HEADLESS
+// Instances stepped side by side instead of sessions (--envs)
+int gVecEnvCount = 0;
+
+// Every global operator new in the headless build is counted, so a run can
+// check that stepping the simulation never allocates (--check-allocations)
+std::atomic<unsigned long long> gAllocationCount{0};
+bool gCheckAllocations = false;
+// --check-rollback: every ROLLBACK_INTERVAL steps, go back ROLLBACK_STEPS
+// through the history and play them again
+bool gCheckRollback = false;
+constexpr int ROLLBACK_INTERVAL = 60, ROLLBACK_STEPS = 30;
+WorldSnapshot gRollbackExpected = WorldSnapshot();
+// --check-vecenv: play each session in a one-instance `VecEnv` too, with the
+// same seed and inputs, and compare the two step by step
+bool gCheckVecEnv = false;
+
+// Both kept out of line so GCC doesn't see malloc()/free() behind them and
+// warn about mismatched allocation functions
+__attribute__((noinline)) void *operator new(size_t size) {
+  gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void *memory = malloc(size ? size : 1))
+    return memory;
+  throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void *memory) noexcept {
+  free(memory);
+}
+void operator delete(void *memory, size_t) noexcept {
+  operator delete(memory);
+}
+#endif // HEADLESS
 // Function Definitions
 
 /**
@@ -58,16 +215,12 @@ Entity *collidable[3];
  */
 bool isColliding(const Vector2 *postionA, const Vector2 *scaleA,
                  const Vector2 *positionB, const Vector2 *scaleB) {
-  float xDistance =
-      fabs(postionA->x - positionB->x) - ((scaleA->x + scaleB->x) / 2.0f);
-  float yDistance =
-      fabs(postionA->y - positionB->y) - ((scaleA->y + scaleB->y) / 2.0f);
-
-  if (xDistance < 0.0f && yDistance < 0.0f)
-    return true;
-  return false;
+  float xOverlap, yOverlap;
+  return BoxOverlap(*postionA, *scaleA, *positionB, *scaleB, &xOverlap,
+                    &yOverlap);
 }
 
+#ifndef HEADLESS
 void renderObject(const Texture2D *texture, const Vector2 *position,
                   const Vector2 *scale) {
   // Whole texture (UV coordinates)
@@ -91,250 +244,1167 @@ void renderObject(const Texture2D *texture, const Vector2 *position,
   DrawTexturePro(*texture, textureArea, destinationArea, originOffset, gAngle,
                  WHITE);
 }
+#endif // HEADLESS
 
 void initialise() {
+  gameState = PLAYING;
+  gFuelAccumulator = 0.0f;
+  gStepCount = 0;
+
+#ifndef HEADLESS
   InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "Flying Bird Game");
+  SetTargetFPS(FPS);
+  gDrawCalls.load();
+
+  // Every sprite goes into one atlas so the scene batches into few draws.
+  // Its files are reserved now and decoded in the background; entities can
+  // be created straight away and pick up their textures once it is packed
+  std::vector<const char *> atlasFilepaths = {BACKGROUND_FP};
+  gLevel.getTextureFilepaths(atlasFilepaths);
+  TextureCache::shared().reserveAtlas(atlasFilepaths.data(),
+                                      (int)atlasFilepaths.size());
+  gAssetLoader.start(atlasFilepaths.data(), (int)atlasFilepaths.size());
+
+  // Hold the background; it is looked up again once the atlas exists
+  TextureCache::shared().acquire(BACKGROUND_FP);
+#endif
   
-  // Load background texture
-  background = LoadTexture(BACKGROUND_FP);
-  
-  // Initialize bird
-  std::map<Direction, std::vector<int>> animationAtlas{
-      {DOWN, {0, 1, 2 ,3,4,5}},
-      {UP, {0, 1, 2,3,4,5}},
-      {LEFT, {0, 1, 2,3,4,5}},
-      {RIGHT, {0, 1, 2,3,4,5}}};
-  bird_entity = new Entity({-SCREEN_HEIGHT/2,-SCREEN_WIDTH/2}, BIRD_BASE_SIZE, BIRD_FP, ATLAS, {6, 9},
-                           animationAtlas, PLAYER);
-  
-  bird_entity->setFrameSpeed(6);
-  bird_entity->setBounciness(0.001f);
-  
-  // Initialize nest platform
-  Vector2 nestPos = {static_cast<float>(GetRandomValue(100, SCREEN_WIDTH - 200)),
-                     static_cast<float>(GetRandomValue(100, SCREEN_HEIGHT - 200))};
-  Vector2 nestSize = {60.0f, 30.0f};
-  Vector2 hawk_enemy_size = {80.0f, 50.0f};
-  nest_platform = new Entity(nestPos, nestSize, NEST_FP, PLATFORM);
-  nest_platform->setPlatformSpeed(2.0f);
-  Vector2 hawk_enemy_1_pos = {static_cast<float>(GetRandomValue(100, SCREEN_WIDTH - 100)),
-                     static_cast<float>(GetRandomValue(100, SCREEN_HEIGHT - 100))};
-  hawk_enemy_1 = new Entity(hawk_enemy_1_pos,hawk_enemy_size,ENEMY_FP,ENEMY);
-  Vector2 hawk_enemy_2_pos = {static_cast<float>(GetRandomValue(100, SCREEN_WIDTH - 100)),
-                     static_cast<float>(GetRandomValue(100, SCREEN_HEIGHT - 100))};
-  hawk_enemy_2 = new Entity(hawk_enemy_2_pos,hawk_enemy_size,ENEMY_FP,ENEMY);
-  
-  hawk_enemy_1->setPlatformSpeed(2.0f);
-  hawk_enemy_2->setPlatformSpeed(5.0f);
+  // Spawn the level's entities; the game rules need its first player
+  // (the bird) and first platform (the nest)
+  gEntityStore.clear();
+  gLevelArena.reset();
+  gEntityPool.init(gLevelArena, gLevel.getEntityCount());
+  gEntityStore.reserve(gLevel.getEntityCount());
+  gEntities.reserve(gLevel.getEntityCount());
+  gAnimatedEntities.reserve(gLevel.getEntityCount());
+  gSpatialHash.reserve(gLevel.getEntityCount());
+  gCandidates.reserve(gLevel.getEntityCount());
+  gLevel.spawn(&gEntityStore, gEntityPool, gEntities);
 
-  collidable[0] = nest_platform;
-  collidable[1] = hawk_enemy_1;
-  collidable[2] = hawk_enemy_2;
+  bird_entity = nullptr;
+  nest_platform = nullptr;
+  for (Entity *entity : gEntities) {
+    if (entity->getTextureType() == ATLAS)
+      gAnimatedEntities.push_back(entity);
+    if (!bird_entity && entity->getEntityType() == PLAYER)
+      bird_entity = entity;
+    else if (!nest_platform && entity->getEntityType() == PLATFORM)
+      nest_platform = entity;
+  }
 
-  SetTargetFPS(FPS);
+  // The history starts at the spawn, so rewinding can go all the way back
+  gHistoryEnabled = (int)gEntities.size() <= WorldSnapshot::MAX_ENTITIES;
+  if (!gHistoryEnabled)
+    LOG("Level has more than " << WorldSnapshot::MAX_ENTITIES
+                               << " entities; rewinding is disabled");
+  gHistory.init(HISTORY_SECONDS * (int)gTimestep.getTickRate(), HISTORY_BYTES);
+  if (gHistoryEnabled) {
+    saveWorld(gWorld);
+    gHistory.push(gWorld);
+  }
+
+#ifndef HEADLESS
+  loadAssets();
+
+  TextureCache &textures = TextureCache::shared();
+  LOG("Loaded " << textures.getTextureCount() << " textures ("
+                << textures.getResidentBytes() / 1024 << " KiB resident)");
+#endif
 }
 
-void processInput() {
-  // Only process movement input if game is still playing
-  if (gameState == PLAYING) {
-    // to close the game
-    if (IsKeyPressed(KEY_W)){
-      bird_entity->jump();
-    }
-    if (bird_entity) {
-      bool moving = false;
-      if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT)) {
-        if (bird_entity->get_fuel_level() > 0) {
-          Vector2 acc = bird_entity->getAcceleration();
-          acc.x = -Entity::HORIZONTAL_ACCELERATION;
-          bird_entity->setAcceleration(acc);
-          moving = true;
-        }
-      } else if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT)) {
-        if (bird_entity->get_fuel_level() > 0) {
-          Vector2 acc = bird_entity->getAcceleration();
-          acc.x = Entity::HORIZONTAL_ACCELERATION;
-          bird_entity->setAcceleration(acc);
-          moving = true;
-        }
-      } else {
-        Vector2 acc = bird_entity->getAcceleration();
-        acc.x = 0.0f;
-        bird_entity->setAcceleration(acc);
-      }
+/**
+ * @brief Milliseconds from `start` to `end`.
+ */
+double millisecondsBetween(std::chrono::steady_clock::time_point start,
+                           std::chrono::steady_clock::time_point end) {
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
 
-      if (moving) {
-        gFuelAccumulator += gDeltaTime;
-        if (gFuelAccumulator >= 0.2f) {
-          bird_entity->edit_fuel_level();
-          gFuelAccumulator = 0.0f;
-        }
-      } else {
-        gFuelAccumulator = 0.0f;
-      }
+#ifndef HEADLESS
+/**
+ * @brief Shows loading frames until every image `initialise()` started
+ * decoding has arrived, then packs them into the atlas and uploads it. Only
+ * the upload happens on this thread; closing the window meanwhile stops
+ * waiting and quits.
+ */
+void loadAssets() {
+  std::vector<AssetLoader::LoadedImage> images;
+  auto start = std::chrono::steady_clock::now();
+
+  while (!gAssetLoader.isDone()) {
+    if (WindowShouldClose()) {
+      gAppStatus = TERMINATED;
+      break;
     }
+    gAssetLoader.takeCompleted(images);
+    renderLoadingFrame((int)images.size(), gAssetLoader.getTotalCount());
+  }
+
+  std::vector<const char *> filepaths;
+  std::vector<Image> decoded;
+  for (const AssetLoader::LoadedImage &loaded : images) {
+    if (loaded.image.data == NULL)
+      LOG("Could not decode " << loaded.filepath);
+    filepaths.push_back(loaded.filepath.c_str());
+    decoded.push_back(loaded.image);
+  }
+
+  auto uploadStart = std::chrono::steady_clock::now();
+  TextureCache::shared().packAtlas(filepaths.data(), decoded.data(),
+                                   (int)decoded.size());
+  auto end = std::chrono::steady_clock::now();
+
+  for (Image &image : decoded)
+    if (image.data != NULL)
+      UnloadImage(image);
+
+  background = TextureCache::shared().getTexture(BACKGROUND_FP);
+  backgroundRegion = TextureCache::shared().getRegion(BACKGROUND_FP);
+
+  LOG("Decoded " << images.size() << " images on "
+                 << gAssetLoader.getThreadCount() << " threads in "
+                 << millisecondsBetween(start, uploadStart) << " ms ("
+                 << gAssetLoader.getDecodeSeconds() * 1000.0
+                 << " ms of decoding), uploaded in "
+                 << millisecondsBetween(uploadStart, end) << " ms");
+  gAssetLoader.finish();
+  loadLayers();
+}
+
+/**
+ * @brief Creates the cached layers and draws the background into its own
+ * one, scaled to the window once instead of every frame. If the background
+ * layer can't be created, render() draws the background directly.
+ */
+void loadLayers() {
+  if (gBackgroundLayer.load(SCREEN_WIDTH, SCREEN_HEIGHT)) {
+    gBackgroundLayer.begin(0, RAYWHITE);
+    DrawTexturePro(background, backgroundRegion,
+                   (Rectangle){0, 0, SCREEN_WIDTH, SCREEN_HEIGHT},
+                   (Vector2){0, 0}, 0.0f, WHITE);
+    gBackgroundLayer.end();
+  }
+
+  // The fuel readout runs to the right edge of the window
+  gFuelLayer.load(100, HUD_FONT_SIZE);
+  gBannerLayer.load(std::max(MeasureText("Game Won!", BANNER_FONT_SIZE),
+                             MeasureText("Game Lost!", BANNER_FONT_SIZE)),
+                    BANNER_FONT_SIZE);
+}
+
+/**
+ * @brief Re-rasterises the HUD text, but only the layers whose inputs (the
+ * bird's fuel, the game state) changed since they were last drawn.
+ */
+void updateHudLayers(const RenderSnapshot &snapshot) {
+  if (bird_entity && gFuelLayer.isStale(snapshot.fuel)) {
+    int fuel = snapshot.fuel;
+    char fuelText[32];
+    snprintf(fuelText, sizeof(fuelText), "Fuel: %d", fuel);//limits how many bytes go into buffer(https://www.geeksforgeeks.org/c/snprintf-c-library/) j bc we are using 32 array 
+
+    gFuelLayer.begin(fuel);
+    DrawText(fuelText, 0, 0, HUD_FONT_SIZE, BLACK);
+    gFuelLayer.end();
+  }
+
+  if (snapshot.gameState != PLAYING &&
+      gBannerLayer.isStale(snapshot.gameState)) {
+    gBannerLayer.begin(snapshot.gameState);
+    if (snapshot.gameState == WON)
+      DrawText("Game Won!", 0, 0, BANNER_FONT_SIZE, GREEN);
+    else
+      DrawText("Game Lost!", 0, 0, BANNER_FONT_SIZE, RED);
+    gBannerLayer.end();
+  }
+}
+
+/**
+ * @brief Draws the loading screen: a caption and a progress bar. Reports
+ * the time to the first frame the first time it is shown.
+ */
+void renderLoadingFrame(int loaded, int total) {
+  constexpr int BAR_WIDTH = 400, BAR_HEIGHT = 20;
+  int barX = SCREEN_WIDTH / 2 - BAR_WIDTH / 2;
+  int barY = SCREEN_HEIGHT / 2;
+
+  BeginDrawing();
+  ClearBackground(RAYWHITE);
+  DrawText("Loading...", barX, barY - 40, 20, DARKGRAY);
+  DrawRectangleLines(barX, barY, BAR_WIDTH, BAR_HEIGHT, DARKGRAY);
+  if (total > 0)
+    DrawRectangle(barX, barY, BAR_WIDTH * loaded / total, BAR_HEIGHT,
+                  DARKGRAY);
+  EndDrawing();
+
+  if (!gHasShownFirstFrame) {
+    gHasShownFirstFrame = true;
+    LOG("First frame (loading) after "
+        << millisecondsBetween(gLaunchTime, std::chrono::steady_clock::now())
+        << " ms");
   }
+}
+#endif // HEADLESS
+
+#ifndef HEADLESS
+void processInput() {
+  PROFILE(PHASE_INPUT);
+  if (IsKeyPressed(KEY_F1))
+    gShowColliders = !gShowColliders;
+  if (IsKeyPressed(KEY_F2))
+    gShowProfiler = !gShowProfiler;
+
+  // A replay takes its input from the recording, one sample per step
+  if (gIsReplaying) {
+    if (WindowShouldClose())
+      gAppStatus = TERMINATED;
+    return;
+  }
+
+  // Only changes are queued: a key held for many frames is one event
+  unsigned char input = pollInput();
+  InputEvent event;
+  event.time = std::chrono::steady_clock::now();
+  event.held = input & (INPUT_LEFT | INPUT_RIGHT | INPUT_REWIND);
+  event.pressed = gPendingPresses | (input & (INPUT_JUMP | INPUT_QUIT));
+  if (event.held == gQueuedHeld && event.pressed == 0)
+    return;
+
+  // Should the simulation fall that far behind, presses wait for room
+  // rather than being lost
+  if (gInputQueue.push(event)) {
+    gQueuedHeld = event.held;
+    gPendingPresses = 0;
+  } else {
+    gPendingPresses = event.pressed;
+  }
+}
+
+/**
+ * @brief Samples the keyboard into a bitmask of `InputFlag`s.
+ */
+unsigned char pollInput() {
+  unsigned char input = 0;
+  if (IsKeyPressed(KEY_W))
+    input |= INPUT_JUMP;
+  if (IsKeyDown(KEY_A) || IsKeyDown(KEY_LEFT))
+    input |= INPUT_LEFT;
+  if (IsKeyDown(KEY_D) || IsKeyDown(KEY_RIGHT))
+    input |= INPUT_RIGHT;
+  if (IsKeyDown(KEY_BACKSPACE))
+    input |= INPUT_REWIND;
   if (IsKeyPressed(KEY_Q) || WindowShouldClose())
+    input |= INPUT_QUIT;
+  return input;
+}
+
+/**
+ * @brief Produces the input for the fixed step due at `stepTime`: read back
+ * from the recording while replaying, otherwise built from the input events
+ * `processInput()` queued up to that time, and appended to the recording if
+ * one is being made. A finished replay quits.
+ *
+ * Events stamped after `stepTime` stay queued for a later step, so a key
+ * change takes effect at the step it happened in, however many steps are
+ * run at once. How long each one waited is recorded under
+ * `PHASE_INPUT_LATENCY`.
+ */
+unsigned char nextStepInput(std::chrono::steady_clock::time_point stepTime) {
+  unsigned char input = 0;
+  if (gIsReplaying) {
+    if (!gRecording.next(&input))
+      input = INPUT_QUIT;
+    return input;
+  }
+
+  InputEvent event;
+  while (gInputQueue.peek(&event) && event.time <= stepTime) {
+    gInputQueue.pop();
+    gStepHeld = event.held;
+    gStepPresses |= event.pressed;
+    PROFILE_SAMPLE(PHASE_INPUT_LATENCY,
+                   (unsigned long long)std::chrono::duration_cast<
+                       std::chrono::nanoseconds>(
+                       std::chrono::steady_clock::now() - event.time)
+                       .count());
+  }
+
+  input = gStepHeld | gStepPresses;
+  gStepPresses = 0;
+  if (gIsRecording)
+    gRecording.record(input);
+  return input;
+}
+#endif // HEADLESS
+
+/**
+ * @brief Scripted stand-in for the keyboard in headless runs. Steers towards
+ * the nest and flaps when the bird sinks below it, with some noise so that
+ * sessions play out differently.
+ */
+unsigned char autopilotInput() {
+  unsigned char input = 0;
+  if (!bird_entity || !nest_platform)
+    return input;
+
+  Vector2 bird = bird_entity->getPosition();
+  Vector2 nest = nest_platform->getPosition();
+
+  if (bird.x < nest.x - 10.0f)
+    input |= INPUT_RIGHT;
+  else if (bird.x > nest.x + 10.0f)
+    input |= INPUT_LEFT;
+
+  if (bird.y > nest.y - 60.0f && bird_entity->getVelocity().y > 0 &&
+      RandomInt(0, 9) == 0)
+    input |= INPUT_JUMP;
+  return input;
+}
+
+/**
+ * @brief Applies one sample of player input to the bird.
+ *
+ * @param input bitmask of `InputFlag`s
+ * @param frameTime time covered by this sample, used to drain fuel while a
+ * horizontal thruster is held
+ */
+void applyInput(unsigned char input, float frameTime) {
+  // Only process movement input if game is still playing
+  if (gameState == PLAYING && bird_entity) {
+    int fuel = bird_entity->get_fuel_level();
+    Vector2 acc = bird_entity->getAcceleration();
+    if (ApplyBirdInput(input, frameTime, fuel, gFuelAccumulator, acc.x))
+      bird_entity->setJumping(true);
+    bird_entity->setFuelLevel(fuel);
+    bird_entity->setAcceleration(acc);
+  }
+  if (input & INPUT_QUIT)
     gAppStatus = TERMINATED;
 }
 
-void update() {
-  float ticks =(float)GetTime();
-  float deltaTime =ticks - gPreviousTicks;
-  gPreviousTicks = ticks;
-  gDeltaTime = deltaTime;
-  
+#ifndef HEADLESS
+/**
+ * @brief Body of the simulation thread. Runs the fixed steps that have come
+ * due, publishes a snapshot of the result for render(), then sleeps until
+ * the next step is due, until the game quits. Nothing here waits on the
+ * render thread, so a slow frame or a vsync stall never holds up physics
+ * or input.
+ *
+ * This thread owns the simulation: the entities, the store, the timestep
+ * and the job system. The render thread only touches the snapshots and
+ * what never changes once the level is loaded.
+ */
+void simulate() {
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point previous = Clock::now();
+  unsigned long long stepCount = 0;
+
+  while (gAppStatus == RUNNING) {
+    Clock::time_point now = Clock::now();
+    float frameTime = std::chrono::duration<float>(now - previous).count();
+    previous = now;
+
+    int steps = update(frameTime, now);
+    if (steps > 0) {
+      stepCount += steps;
+      captureSnapshot(gSnapshots.getWriteBuffer(), stepCount,
+                      stepDueTime(now, 0));
+      gSnapshots.publish();
+    }
+
+    if (!gFastReplay)
+      std::this_thread::sleep_for(std::chrono::duration<float>(
+          (1.0f - gTimestep.getAlpha()) * gTimestep.getStep()));
+  }
+}
+
+/**
+ * @brief When a fixed step came due, given the timestep has just been
+ * advanced to `now`: the latest step was due as long ago as the
+ * accumulator holds, and each one before it a step earlier still.
+ *
+ * @param stepsBefore 0 for the latest step, 1 for the one before it, ...
+ */
+std::chrono::steady_clock::time_point
+stepDueTime(std::chrono::steady_clock::time_point now, int stepsBefore) {
+  return now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                   std::chrono::duration<float>(
+                       (gTimestep.getAlpha() + stepsBefore) *
+                       gTimestep.getStep()));
+}
+
+/**
+ * @brief Runs the fixed steps covering `frameTime` seconds of real time,
+ * ending at `now` (or a fixed batch of them when replaying with `--fast`).
+ * Each step takes the input that had arrived by the time it was due.
+ *
+ * @return how many steps were run
+ */
+int update(float frameTime, std::chrono::steady_clock::time_point now) {
+  PROFILE(PHASE_UPDATE);
+  // Physics always advances in whole fixed steps; whatever is left over in
+  // the accumulator is used by render() to interpolate between states
+  int steps = gTimestep.advance(frameTime);
+  if (gFastReplay)
+    steps = FAST_REPLAY_STEPS_PER_FRAME;
+
+  // Input is applied per step rather than per frame so that a recording
+  // replays identically whatever the frame rate was
+  int stepped = 0;
+  for (; stepped < steps && gAppStatus == RUNNING; stepped++)
+    advanceWorld(nextStepInput(stepDueTime(now, steps - 1 - stepped)),
+                 gTimestep.getStep());
+  return stepped;
+}
+
+/**
+ * @brief Copies what render() draws out of the simulation: every entity's
+ * positions, angle and animation frame, the bird's fuel and the game state.
+ * `snapshot` must already hold one entry per entity, so this never
+ * allocates.
+ */
+void captureSnapshot(RenderSnapshot &snapshot, unsigned long long stepCount,
+                     std::chrono::steady_clock::time_point stepTime) {
+  for (size_t i = 0; i < gEntities.size(); i++)
+    gEntities[i]->capture(snapshot.entities[i]);
+  snapshot.fuel = bird_entity ? bird_entity->get_fuel_level() : 0;
+  snapshot.gameState = gameState;
+  snapshot.stepCount = stepCount;
+  snapshot.stepTime = stepTime;
+}
+#endif // HEADLESS
+
+/**
+ * @brief Runs one fixed step with `input` and saves the result into the
+ * history, or, while `INPUT_REWIND` is held, goes back one frame of history
+ * instead. Rewinding is driven by the step's input like everything else, so
+ * a recording with rewinds in it replays the same way. Without a history
+ * (see `gHistoryEnabled`) rewinding holds the world where it is, as it does
+ * at the start of the history.
+ */
+void advanceWorld(unsigned char input, float deltaTime) {
+  if (input & INPUT_REWIND) {
+    PROFILE(PHASE_HISTORY);
+    if (gHistoryEnabled && gHistory.rewind(gWorld))
+      restoreWorld(gWorld);
+    if (input & INPUT_QUIT)
+      gAppStatus = TERMINATED;
+    return;
+  }
+
+  applyInput(input, deltaTime);
+  step(deltaTime);
+  if (!gHistoryEnabled)
+    return;
+
+  PROFILE(PHASE_HISTORY);
+  saveWorld(gWorld);
+  gHistory.push(gWorld);
+}
+
+/**
+ * @brief Copies everything a step changes into `snapshot`: the store's
+ * per-step arrays, each entity's own state, the game rules' globals and the
+ * random generator. Never allocates.
+ */
+void saveWorld(WorldSnapshot &snapshot) {
+  snapshot.stepCount = gStepCount;
+  snapshot.gameState = gameState;
+  snapshot.fuelAccumulator = gFuelAccumulator;
+  snapshot.randomState = GetRandomState();
+  if (!gEntityStore.save(snapshot))
+    return;
+  for (size_t i = 0; i < gEntities.size(); i++)
+    gEntities[i]->saveState(snapshot.entities[i]);
+}
+
+/**
+ * @brief Puts the simulation back to where `saveWorld()` found it. The
+ * level must be the one that was spawned then.
+ *
+ * @return false if the snapshot is from a different level; nothing is
+ * restored then
+ */
+bool restoreWorld(const WorldSnapshot &snapshot) {
+  if (snapshot.entityCount != (int)gEntities.size() ||
+      !gEntityStore.restore(snapshot))
+    return false;
+  for (size_t i = 0; i < gEntities.size(); i++)
+    gEntities[i]->restoreState(snapshot.entities[i]);
+  gStepCount = snapshot.stepCount;
+  gameState = (GameState)snapshot.gameState;
+  gFuelAccumulator = snapshot.fuelAccumulator;
+  SeedRandom(snapshot.randomState);
+  return true;
+}
+
+void step(float deltaTime) {
+  PROFILE(PHASE_STEP);
+  gFrameArena.reset();
+  gStepCount++;
+  // Every entity starts the step where the last one left it, so whatever
+  // doesn't move (everything, once the game is over) interpolates to a
+  // standstill instead of between two stale states
+  gEntityStore.previousPositions = gEntityStore.positions;
   // Only update movement if game is still playing
   if (gameState == PLAYING) {
-    if (nest_platform) {
-      nest_platform->update(deltaTime, nullptr, 0);
+    // Patrols only matter where they can be drawn or touched: on screen, and
+    // anywhere the bird can reach this step
+    Rectangle patrolArea = {0.0f, 0.0f, SCREEN_WIDTH, SCREEN_HEIGHT};
+    Vector2 birdReach = {0.0f, 0.0f};
+    if (bird_entity) {
+      Vector2 birdPosition = bird_entity->getPosition();
+      birdReach = bird_entity->getBroadphaseDimensions(deltaTime);
+      float left = fminf(0.0f, birdPosition.x - birdReach.x / 2.0f);
+      float top = fminf(0.0f, birdPosition.y - birdReach.y / 2.0f);
+      float right = fmaxf(SCREEN_WIDTH, birdPosition.x + birdReach.x / 2.0f);
+      float bottom = fmaxf(SCREEN_HEIGHT, birdPosition.y + birdReach.y / 2.0f);
+      patrolArea = {left, top, right - left, bottom - top};
     }
-    if (hawk_enemy_1){
-      hawk_enemy_1->update(deltaTime,nullptr,0);
-    } 
-    if (hawk_enemy_2){
-      hawk_enemy_2->update(deltaTime,nullptr,0);
-    } 
+
+    // Phase 1: nest and hawks go where their patrol paths have them at this
+    // step, and every animated entity advances its clip. Neither reads what
+    // the other writes, so both run as one range, patrols first, in parallel
+    // chunks
+    double time = (double)gStepCount * deltaTime;
+    int patrolCount = gEntityStore.getPatrolCount();
+    int animatedCount = (int)gAnimatedEntities.size();
+    gJobSystem.parallelFor(
+        patrolCount + animatedCount, PHASE_ONE_GRAIN_SIZE,
+        [time, patrolArea, patrolCount, deltaTime](int begin, int end) {
+          if (begin < patrolCount)
+            gEntityStore.updatePatrols(time, patrolArea, begin,
+                                       std::min(end, patrolCount));
+          int first = std::max(begin, patrolCount) - patrolCount;
+          if (end - patrolCount > first)
+            Entity::animateAll(gAnimatedEntities.data() + first,
+                               end - patrolCount - first, deltaTime);
+        });
+    gSpatialHash.rebuild(gEntityStore);
     
     if (bird_entity) {
-      bird_entity->update(deltaTime, collidable, 3); 
+      // Narrow phase only against what shares a grid cell with the bird's
+      // reachable area this step
+      int candidateCount =
+          gSpatialHash.queryRegion(bird_entity->getPosition(), birdReach,
+                                   gCandidates, bird_entity->getHandle());
+      // Resolved in level order, whatever order the grid found them in, as
+      // `VecEnv` resolves them
+      std::sort(gCandidates.begin(), gCandidates.begin() + candidateCount);
+
+      // Phase 2: collision resolution against the positions phase 1 left,
+      // which also lists every contact the bird made for the rules below
+      int candidateStart[] = {0, candidateCount};
+      ContactList contacts;
+      gEntityStore.takeSnapshot();
+      Entity::updateParallel(gJobSystem, &bird_entity, 1, candidateStart,
+                             gCandidates.data(), deltaTime, gFrameArena,
+                             &contacts);
+      gEntityStore.releaseSnapshot();
 
       Vector2 pos = bird_entity->getPosition();
       Vector2 vel = bird_entity->getVelocity();
-
-      float halfW = bird_entity->getScale().x / 2.0f;
-      if (pos.x - halfW < 0) {
-        pos.x = halfW;
-        vel.x = -vel.x * bird_entity->getBounciness();
-      } else if (pos.x + halfW > SCREEN_WIDTH) {
-        pos.x = SCREEN_WIDTH - halfW;
-        vel.x = -vel.x * bird_entity->getBounciness();
-      }
-
-      float halfH = bird_entity->getScale().y / 2.0f;
-      if (pos.y - halfH < 0) {
-        pos.y = halfH;
-        vel.y = -vel.y * bird_entity->getBounciness();
-      } else if (pos.y + halfH > SCREEN_HEIGHT) {
+      if (!ConfineToScreen(pos, vel, bird_entity->getScale(),
+                           bird_entity->getBounciness()))
         gameState = LOST;
-        pos.y = SCREEN_HEIGHT - halfH;
-        vel.y = 0; 
-        vel.x = 0; 
-      }
-
       bird_entity->setPosition(pos);
       bird_entity->setVelocity(vel);
 
       if (gameState == PLAYING && nest_platform) {
-        Vector2 birdScale = bird_entity->getScale();
-        Vector2 nestPos = nest_platform->getPosition();
-        Vector2 nestScale = nest_platform->getScale();
-        Vector2 enemy1Pos = hawk_enemy_1->getPosition();
-        Vector2 enemy1Scale = hawk_enemy_1->getScale();
-        Vector2 enemy2Pos = hawk_enemy_2->getPosition();
-        Vector2 enemy2Scale = hawk_enemy_2->getScale();
-        
-        Vector2 expandedNestScale = nestScale;
-        Vector2 expandedEnemy1Scale = enemy1Scale;
-        Vector2 expandedEnemy2Scale = enemy2Scale;
-        expandedNestScale.x *= 1.1f;  
-        expandedNestScale.y *= 1.1f; 
-        expandedEnemy1Scale.x *= 1.1f; 
-        expandedEnemy1Scale.y *= 1.1f;
-        expandedEnemy2Scale.x *= 1.1f;
-        expandedEnemy2Scale.y *= 1.1f;
-        
-        if (isColliding(&pos, &birdScale, &nestPos, &expandedNestScale) &&
-            vel.y >= 0) {
-          gameState = WON;
+        // The collision stage has already found which sensors the bird is
+        // inside; the rules are shared with `VecEnv`
+        EpisodeOutcome outcome =
+            JudgeContacts(contacts, gEntityStore.types.data(), vel);
+        if (outcome != EPISODE_RUNNING) {
+          gameState = outcome == EPISODE_WON ? WON : LOST;
           bird_entity->setVelocity({0, 0});
           bird_entity->setAcceleration({0, 0});
         }
-        if (isColliding(&pos, &birdScale, &enemy1Pos, &expandedEnemy1Scale)) {
-          gameState = LOST;
-          bird_entity->setVelocity({0, 0});
-          bird_entity->setAcceleration({0, 0});
-        } 
-        if (isColliding(&pos, &birdScale, &enemy2Pos, &expandedEnemy2Scale)) {
-          gameState = LOST;
-          bird_entity->setVelocity({0, 0});
-          bird_entity->setAcceleration({0, 0});}
-        // }
-        // if (bird_entity->get_fuel_level() <= 0 && 
-        //     pos.y > nestPos.y + nestScale.y) {
-        //   gameState = LOST;
-        // }
       }
     }
   }
 }
 
+#ifndef HEADLESS
+/**
+ * @brief Draws the latest snapshot the simulation thread has published,
+ * interpolated by how far real time has got into the step after it.
+ */
 void render() {
+  PROFILE(PHASE_RENDER);
+  gSnapshots.acquire();
+  const RenderSnapshot &snapshot = gSnapshots.getReadBuffer();
+
+  float alpha = std::chrono::duration<float>(
+                    std::chrono::steady_clock::now() - snapshot.stepTime)
+                    .count() /
+                gTimestep.getStep();
+  alpha = alpha < 0.0f ? 0.0f : alpha > 1.0f ? 1.0f : alpha;
+
+  // Render textures can't be drawn into mid-frame
+  updateHudLayers(snapshot);
+
   BeginDrawing();
-  ClearBackground(RAYWHITE);
-  
-  DrawTexturePro(background,
-                 (Rectangle){0, 0, (float)background.width, (float)background.height},
-                 (Rectangle){0, 0, SCREEN_WIDTH, SCREEN_HEIGHT},
-                 (Vector2){0, 0}, 0.0f, WHITE);
-  
-  if (nest_platform)
-    nest_platform->render();
-  
-  if (hawk_enemy_1)
-    hawk_enemy_1->render();
-  if (hawk_enemy_2)
-    hawk_enemy_2->render();
-  
+  gDrawCalls.begin();
+  // The background is opaque and covers the window, so its layer stands in
+  // for clearing the screen
+  if (gBackgroundLayer.isLoaded()) {
+    gBackgroundLayer.draw((Vector2){0, 0});
+  } else {
+    ClearBackground(RAYWHITE);
+    DrawTexturePro(background, backgroundRegion,
+                   (Rectangle){0, 0, SCREEN_WIDTH, SCREEN_HEIGHT},
+                   (Vector2){0, 0}, 0.0f, WHITE);
+  }
+
+  gDrawCalls.sample();
+
+  gSpriteBatch.begin();
+  for (size_t i = 0; i < gEntities.size(); i++)
+    gEntities[i]->render(gSpriteBatch, snapshot.entities[i], alpha);
+  gSpriteBatch.end(&gDrawCalls);
+
+  // Debug overlay (F1): collider outlines, batch statistics (draw calls and
+  // flushes are last frame's, as rlgl submitted them), how often the HUD
+  // has been re-rasterised and how many steps have been simulated
+  if (gShowColliders) {
+    for (size_t i = 0; i < gEntities.size(); i++)
+      gEntities[i]->displayCollider(snapshot.entities[i], alpha);
+
+    gDrawCalls.sample();
+
+    char statsText[160];
+    snprintf(statsText, sizeof(statsText),
+             "sprites %d  draws %d  flushes %d  binds %d  hud redraws %d  "
+             "steps %llu",
+             gSpriteBatch.getSpriteCount(), gDrawCalls.getDrawCalls(),
+             gDrawCalls.getFlushes(), gSpriteBatch.getTextureBinds(),
+             gFuelLayer.getRedrawCount() + gBannerLayer.getRedrawCount(),
+             snapshot.stepCount);
+    DrawText(statsText, 10, 10, 20, BLACK);
+    gDrawCalls.sample();
+  }
+
+#ifdef ENABLE_PROFILER
+  // Profiler overlay (F2): per-phase timings and frame-time histogram
+  if (gShowProfiler)
+    Profiler::shared().drawOverlay(10, 40);
+  gDrawCalls.sample();
+#endif
+
   if (bird_entity)
-    bird_entity->render();
+    gFuelLayer.draw((Vector2){SCREEN_WIDTH - 100, 10});
+  if (snapshot.gameState != PLAYING)
+    gBannerLayer.draw((Vector2){SCREEN_WIDTH / 2 - 100, SCREEN_HEIGHT / 2 - 20});
 
-  if (bird_entity) {
-    char fuelText[32];
-    snprintf(fuelText, sizeof(fuelText), "Fuel: %d", bird_entity->get_fuel_level());//limits how many bytes go into buffer(https://www.geeksforgeeks.org/c/snprintf-c-library/) j bc we are using 32 array 
-    DrawText(fuelText, SCREEN_WIDTH - 100, 10, 20, BLACK);
+  gDrawCalls.end();
+  EndDrawing();
+}
+#endif // HEADLESS
+
+void shutdown() {
+  gEntityPool.clear();
+  gEntities.clear();
+  gAnimatedEntities.clear();
+  bird_entity = nullptr;
+  nest_platform = nullptr;
+  gEntityStore.clear();
+  gLevelArena.reset();
+#ifndef HEADLESS
+  gAssetLoader.finish();
+  gBackgroundLayer.unload();
+  gFuelLayer.unload();
+  gBannerLayer.unload();
+  gDrawCalls.unload();
+  TextureCache::shared().release(BACKGROUND_FP);
+  TextureCache::shared().releaseAtlas();
+  CloseWindow();
+
+#ifdef ENABLE_PROFILER
+  Profiler::shared().exportCSV(PROFILE_CSV_FP);
+  Profiler::shared().exportJSON(PROFILE_JSON_FP);
+  LOG("Wrote profile to " << PROFILE_CSV_FP << " and " << PROFILE_JSON_FP);
+#endif
+#endif
+}
+
+/**
+ * @brief Pulls `--record <file>`, `--replay <file>`, `--fast`,
+ * `--workers <count>`, `--level <file>` and (headless only)
+ * `--check-allocations`, `--check-rollback`, `--check-vecenv` and
+ * `--envs <count>` out of the command line, leaving everything else in
+ * `positional` in order.
+ */
+void parseArguments(int argc, char *argv[],
+                    std::vector<const char *> &positional) {
+  for (int i = 1; i < argc; i++) {
+    std::string argument = argv[i];
+    if (argument == "--record" && i + 1 < argc) {
+      gIsRecording = true;
+      gRecordingPath = argv[++i];
+    } else if (argument == "--replay" && i + 1 < argc) {
+      gIsReplaying = true;
+      gRecordingPath = argv[++i];
+    } else if (argument == "--fast") {
+      gFastReplay = true;
+    } else if (argument == "--workers" && i + 1 < argc) {
+      gWorkerCount = atoi(argv[++i]);
+    } else if (argument == "--level" && i + 1 < argc) {
+      gLevelPath = argv[++i];
+#ifdef HEADLESS
+    } else if (argument == "--check-allocations") {
+      gCheckAllocations = true;
+    } else if (argument == "--check-rollback") {
+      gCheckRollback = true;
+    } else if (argument == "--check-vecenv") {
+      gCheckVecEnv = true;
+    } else if (argument == "--envs" && i + 1 < argc) {
+      gVecEnvCount = atoi(argv[++i]);
+#endif
+    } else {
+      positional.push_back(argv[i]);
+    }
   }
+  gIsRecording = gIsRecording && !gIsReplaying;
+  gFastReplay = gFastReplay && gIsReplaying;
+}
 
-  const char* message = "";
-  Color messageColor = WHITE;
-  if (gameState == WON) {
-    message = "Game Won!";
-    messageColor = GREEN;
-  } else if (gameState == LOST) {
-    message = "Game Lost!";
-    messageColor = RED;
+/**
+ * @brief Loads the `--replay` file and adopts the seed and tick rate it was
+ * recorded with.
+ *
+ * @return false if the recording could not be read
+ */
+bool loadReplay() {
+  if (!gRecording.load(gRecordingPath)) {
+    LOG("Could not read recording " << gRecordingPath);
+    return false;
   }
-  
-  if (gameState != PLAYING) {
-    DrawText(message, SCREEN_WIDTH/2 - 100, SCREEN_HEIGHT/2 - 20, 40, messageColor);
+  gTimestep.setTickRate(gRecording.getTickRate());
+  LOG("Replaying " << gRecording.getStepCount() << " steps ("
+                   << gRecording.getRunCount() << " runs) from "
+                   << gRecordingPath);
+  return true;
+}
+
+/**
+ * @brief Maps the level file chosen with `--level` (or the default one).
+ *
+ * @return false if it is missing or malformed
+ */
+bool loadLevel() {
+  auto start = std::chrono::steady_clock::now();
+  if (!gLevel.open(gLevelPath)) {
+    LOG("Could not load level " << gLevelPath
+                                << " (run `make levels` to compile it)");
+    return false;
   }
+  double microseconds = std::chrono::duration<double, std::micro>(
+                            std::chrono::steady_clock::now() - start).count();
+  LOG("Loaded level " << gLevelPath << " (" << gLevel.getEntityCount()
+                      << " entities) in " << microseconds << " us");
+  return true;
+}
 
-  EndDrawing();
+/**
+ * @brief Writes the `--record` file, if one was requested.
+ */
+void saveRecording() {
+  if (!gIsRecording)
+    return;
+  if (gRecording.save(gRecordingPath))
+    LOG("Recorded " << gRecording.getStepCount() << " steps ("
+                    << gRecording.getRunCount() << " runs) to "
+                    << gRecordingPath);
+  else
+    LOG("Could not write recording " << gRecordingPath);
 }
 
-void shutdown() {
-  if (bird_entity) {
-    delete bird_entity;
-    bird_entity = nullptr;
+#ifdef HEADLESS
+/**
+ * Rolls the simulation back up to `ROLLBACK_STEPS` steps through the
+ * history and runs them again with the autopilot. The restored random
+ * generator makes the autopilot choose the same inputs, so the world must
+ * come out byte for byte as it was.
+ *
+ * @return false if it didn't
+ */
+bool checkRollback(float deltaTime) {
+  gRollbackExpected = gHistory.getLatest();
+
+  int rewound = 0;
+  while (rewound < ROLLBACK_STEPS && gHistory.rewind(gWorld))
+    rewound++;
+  if (!restoreWorld(gWorld))
+    return false;
+
+  for (int i = 0; i < rewound; i++) {
+    applyInput(autopilotInput(), deltaTime);
+    step(deltaTime);
+    saveWorld(gWorld);
+    gHistory.push(gWorld);
+  }
+  return memcmp(&gWorld, &gRollbackExpected, sizeof(WorldSnapshot)) == 0;
+}
+
+/**
+ * Whether instance 0 of `env`, stepped with the same inputs as the game,
+ * agrees with it after a step: the same outcome, and while both still play,
+ * the bird in the same place at the same velocity, bit for bit.
+ */
+bool vecEnvMatches(const VecEnv &env) {
+  unsigned char outcome = env.getOutcomes()[0];
+  if (gameState == WON)
+    return outcome == EPISODE_WON;
+  if (gameState == LOST)
+    return outcome == EPISODE_LOST;
+  if (outcome != EPISODE_RUNNING)
+    return false;
+
+  Vector2 position = bird_entity->getPosition();
+  Vector2 velocity = bird_entity->getVelocity();
+  return memcmp(&position, &env.getPositions()[0], sizeof(Vector2)) == 0 &&
+         memcmp(&velocity, &env.getVelocities()[0], sizeof(Vector2)) == 0;
+}
+
+/**
+ * Replays a recording with no window or frame pacing, as fast as the
+ * simulation can run, and reports where the bird ended up.
+ */
+int replayHeadless() {
+  if (!loadReplay())
+    return 1;
+
+  float deltaTime = gTimestep.getStep();
+  int steps = 0;
+  unsigned char input;
+
+  SeedRandom(gRecording.getSeed());
+  initialise();
+
+  // A recording that rewinds can carry on past a win or loss, so it is
+  // played to its end unless it has no rewinds in it
+  bool canRewind = false;
+  while (gRecording.next(&input))
+    canRewind = canRewind || (input & INPUT_REWIND);
+  gRecording.rewind();
+
+  auto start = std::chrono::steady_clock::now();
+  while ((gameState == PLAYING || canRewind) && gAppStatus == RUNNING &&
+         gRecording.next(&input)) {
+    advanceWorld(input, deltaTime);
+    steps++;
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start).count();
+
+  const char *outcome = gameState == WON    ? "won"
+                        : gameState == LOST ? "lost"
+                                            : "still playing";
+  Vector2 bird = bird_entity->getPosition();
+  LOG("Replayed " << steps << " steps in " << seconds << " s: " << outcome
+                  << " with bird at (" << bird.x << ", " << bird.y
+                  << "), fuel " << bird_entity->get_fuel_level());
+  shutdown();
+  return 0;
+}
+
+/**
+ * Steps `gVecEnvCount` instances of the level in a `VecEnv` for `steps`
+ * lockstep steps, split across the job system, with every instance steered
+ * the way `autopilotInput()` steers the bird. Reports env-steps per second
+ * (stepping only, not choosing actions) and how the episodes ended.
+ */
+int runVecEnvHeadless(int steps) {
+  VecEnv env;
+  if (!env.init(gLevel, gVecEnvCount, 1)) {
+    LOG("Level " << gLevelPath << " has no player to run instances of");
+    return 1;
   }
-  if (nest_platform) {
-    delete nest_platform;
-    nest_platform = nullptr;
+
+  int nest = -1;
+  for (int h = 0; h < env.getHazardCount() && nest < 0; h++)
+    if (env.getHazardType(h) == PLATFORM)
+      nest = h;
+
+  float deltaTime = gTimestep.getStep();
+  int count = env.getInstanceCount();
+  std::vector<unsigned char> actions(count);
+  long long wins = 0, losses = 0;
+  double seconds = 0.0;
+
+  SeedRandom(1);
+  for (int i = 0; i < steps; i++) {
+    const Vector2 *positions = env.getPositions();
+    const Vector2 *velocities = env.getVelocities();
+    const Vector2 *hazards = env.getHazardPositions();
+
+    for (int e = 0; e < count; e++) {
+      unsigned char input = 0;
+      if (nest >= 0) {
+        Vector2 bird = positions[e];
+        Vector2 target = hazards[e * env.getHazardCount() + nest];
+        if (bird.x < target.x - 10.0f)
+          input |= INPUT_RIGHT;
+        else if (bird.x > target.x + 10.0f)
+          input |= INPUT_LEFT;
+        if (bird.y > target.y - 60.0f && velocities[e].y > 0 &&
+            RandomInt(0, 9) == 0)
+          input |= INPUT_JUMP;
+      }
+      actions[e] = input;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    gJobSystem.parallelFor(count, VEC_ENV_GRAIN_SIZE,
+                           [&](int begin, int end) {
+                             env.step(actions.data(), deltaTime, begin, end);
+                           });
+    seconds += std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start).count();
+
+    const unsigned char *outcomes = env.getOutcomes();
+    for (int e = 0; e < count; e++) {
+      wins += outcomes[e] == EPISODE_WON;
+      losses += outcomes[e] == EPISODE_LOST;
+    }
   }
-  UnloadTexture(background);
-  CloseWindow();
+  if (seconds <= 0.0)
+    seconds = 1e-9;
+
+  long long envSteps = (long long)steps * count;
+  LOG(count << " instances x " << steps << " steps on "
+            << gJobSystem.getThreadCount() << " threads in " << seconds
+            << " s (" << (long long)(envSteps / seconds)
+            << " env-steps/sec)");
+  LOG("episodes won " << wins << ", lost " << losses);
+  return 0;
+}
+
+/**
+ * Headless entry point: plays back-to-back sessions driven by
+ * `autopilotInput()` with no window, textures or frame pacing, and reports
+ * simulation throughput. `--record <file>` saves the first session's input;
+ * `--replay <file>` plays a recording back instead.
+ *
+ * Heap allocations made while stepping are counted from the second session
+ * on (the first warms up every reusable buffer); `--check-allocations`
+ * fails the run if there were any.
+ *
+ * `--check-rollback` also saves every step into the history and regularly
+ * rolls back and re-simulates (see `checkRollback()`), failing the run if
+ * any rollback didn't reproduce the world it started from.
+ *
+ * `--check-vecenv` plays every session in a one-instance `VecEnv` as well,
+ * seeded and steered the same way, failing the run if any step of it
+ * disagrees with the game (see `vecEnvMatches()`).
+ *
+ * `--envs <count>` runs that many instances side by side in a `VecEnv`
+ * instead (see `runVecEnvHeadless()`), for a number of lockstep steps.
+ *
+ * Usage: ./headless_app [sessions] [max steps per session] [tick rate]
+ *                       [--record <file> | --replay <file>]
+ *                       [--workers <count>] [--level <file>]
+ *                       [--check-allocations] [--check-rollback]
+ *                       [--check-vecenv]
+ *        ./headless_app [steps] [tick rate] --envs <count>
+ *                       [--workers <count>] [--level <file>]
+ */
+int main(int argc, char *argv[]) {
+  std::vector<const char *> args;
+  parseArguments(argc, argv, args);
+  gJobSystem.setWorkerCount(gWorkerCount);
+  if (!loadLevel())
+    return 1;
+  if (gIsReplaying)
+    return replayHeadless();
+  if (gVecEnvCount > 0) {
+    if (args.size() > 1)
+      gTimestep.setTickRate((float)atof(args[1]));
+    return runVecEnvHeadless(args.size() > 0 ? atoi(args[0]) : 10000);
+  }
+
+  int sessions = args.size() > 0 ? atoi(args[0]) : 1000;
+  int maxSteps = args.size() > 1 ? atoi(args[1]) : 60 * (int)PHYSICS_HZ;
+  if (args.size() > 2)
+    gTimestep.setTickRate((float)atof(args[2]));
+
+  float deltaTime = gTimestep.getStep();
+  long long totalSteps = 0;
+  int wins = 0, losses = 0;
+  unsigned long long steadyAllocations = 0;
+  long long rollbacks = 0, rollbackMismatches = 0;
+  double rollbackSeconds = 0.0;
+  VecEnv env;
+  int vecEnvMismatches = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int session = 0; session < sessions; session++) {
+    SeedRandom((unsigned int)session + 1);
+    initialise();
+    if (session == 0)
+      gRecording = InputRecording(1, gTimestep.getTickRate());
+    if (gCheckVecEnv && !env.init(gLevel, 1, (unsigned int)session + 1)) {
+      LOG("Level " << gLevelPath << " has no player to run instances of");
+      return 1;
+    }
+    bool vecEnvMatched = true;
+
+    unsigned long long allocationsBefore = gAllocationCount.load();
+    for (int i = 0; i < maxSteps && gameState == PLAYING; i++) {
+      unsigned char input = autopilotInput();
+      if (session == 0 && gIsRecording)
+        gRecording.record(input);
+      applyInput(input, deltaTime);
+      PROFILE_NEXT_FRAME();
+      step(deltaTime);
+      totalSteps++;
+
+      if (gCheckVecEnv && vecEnvMatched) {
+        env.step(&input, deltaTime);
+        vecEnvMatched = vecEnvMatches(env);
+      }
+
+      if (gCheckRollback && gHistoryEnabled) {
+        auto rollbackStart = std::chrono::steady_clock::now();
+        saveWorld(gWorld);
+        gHistory.push(gWorld);
+        if ((i + 1) % ROLLBACK_INTERVAL == 0) {
+          rollbacks++;
+          rollbackMismatches += !checkRollback(deltaTime);
+        }
+        rollbackSeconds += std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() -
+                               rollbackStart).count();
+      }
+    }
+    if (session > 0)
+      steadyAllocations += gAllocationCount.load() - allocationsBefore;
+    vecEnvMismatches += !vecEnvMatched;
+
+    if (gameState == WON)
+      wins++;
+    else if (gameState == LOST)
+      losses++;
+    shutdown();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start).count();
+  if (seconds <= 0.0)
+    seconds = 1e-9;
+
+  LOG(sessions << " sessions, " << totalSteps << " steps in " << seconds
+               << " s (" << (long long)(totalSteps / seconds)
+               << " steps/sec, " << (long long)(sessions / seconds)
+               << " sessions/sec)");
+  LOG("won " << wins << ", lost " << losses << ", timed out "
+             << sessions - wins - losses);
+  LOG(steadyAllocations << " heap allocations while stepping after warm-up");
+  if (gCheckRollback)
+    LOG(rollbacks << " rollbacks of " << ROLLBACK_STEPS << " steps, "
+                  << rollbackMismatches << " mismatched; history took "
+                  << rollbackSeconds << " s, last held "
+                  << gHistory.getFrameCount() << " frames in "
+                  << gHistory.getBytesUsed() / 1024 << " KiB");
+  if (gCheckVecEnv)
+    LOG(vecEnvMismatches << " of " << sessions
+                         << " sessions played differently in a VecEnv");
+  saveRecording();
+
+#ifdef ENABLE_PROFILER
+  Profiler::shared().exportCSV(PROFILE_CSV_FP);
+  Profiler::shared().exportJSON(PROFILE_JSON_FP);
+  LOG("Wrote profile to " << PROFILE_CSV_FP << " and " << PROFILE_JSON_FP);
+#endif
+  if (gCheckAllocations && steadyAllocations > 0) {
+    LOG("Allocation check failed: the steady-state loop allocated");
+    return 1;
+  }
+  if (gCheckRollback && !gHistoryEnabled) {
+    LOG("Rollback check failed: the level is too big to keep a history");
+    return 1;
+  }
+  if (gCheckRollback && rollbackMismatches > 0) {
+    LOG("Rollback check failed: re-simulating diverged");
+    return 1;
+  }
+  if (gCheckVecEnv && vecEnvMismatches > 0) {
+    LOG("VecEnv check failed: an instance diverged from the game");
+    return 1;
+  }
+  return 0;
 }
+#else
+/**
+ * Usage: ./raylib_app [tick rate] [--record <file>] [--workers <count>]
+ *                     [--level <file>]
+ *        ./raylib_app --replay <file> [--fast] [--workers <count>]
+ *                     [--level <file>]
+ *
+ * The simulation runs on its own thread at the fixed tick rate (see
+ * `simulate()`), while this one polls input and draws whatever snapshot it
+ * published last.
+ *
+ * A replay runs in real time unless `--fast` is given, in which case frame
+ * pacing is turned off and the simulation thread runs fixed batches of
+ * steps back to back.
+ */
+int main(int argc, char *argv[]) {
+  gLaunchTime = std::chrono::steady_clock::now();
+  std::vector<const char *> args;
+  parseArguments(argc, argv, args);
+  gJobSystem.setWorkerCount(gWorkerCount);
+  if (!loadLevel())
+    return 1;
+
+  // Optional physics tick rate, e.g. `./raylib_app 30`
+  if (args.size() > 0)
+    gTimestep.setTickRate((float)atof(args[0]));
+
+  unsigned int seed = (unsigned int)time(NULL);
+  if (gIsReplaying) {
+    if (!loadReplay())
+      return 1;
+    seed = gRecording.getSeed();
+  } else if (gIsRecording) {
+    gRecording = InputRecording(seed, gTimestep.getTickRate());
+  }
 
-int main(void) {
+  SeedRandom(seed);
   initialise();
+  if (gFastReplay)
+    SetTargetFPS(0);
 
+  // Settle every entity on its packed texture up front, and give render()
+  // the starting positions to show until the first steps are published
+  for (Entity *entity : gEntities)
+    entity->refreshTexture();
+  RenderSnapshot initial;
+  initial.entities.resize(gEntities.size());
+  captureSnapshot(initial, 0, std::chrono::steady_clock::now());
+  gSnapshots.reset(initial);
+
+  gSimulationThread = std::thread(simulate);
+
+  bool hasShownScene = false;
   while (gAppStatus == RUNNING) {
+    PROFILE_NEXT_FRAME();
+    PROFILE(PHASE_FRAME);
     processInput();
-    update();
     render();
+
+    if (!hasShownScene) {
+      hasShownScene = true;
+      LOG("First scene frame after "
+          << millisecondsBetween(gLaunchTime,
+                                 std::chrono::steady_clock::now())
+          << " ms");
+    }
   }
 
+  gSimulationThread.join();
   shutdown();
+  saveRecording();
 
   return 0;
 }
+#endif // HEADLESS
@@ -0,0 +1,185 @@
+/**
+ * Checks every SIMD collision kernel against the scalar one, bit for bit:
+ * hit counts, hit masks and both overlap arrays, on random boxes, edge
+ * cases and batch sizes around the SIMD and mask widths. Kernels the CPU
+ * lacks are reported and skipped. Exits with status 1 if any differ.
+ *
+ * Built headless against the collision code alone (see `make
+ * check-collision`).
+ *
+ * Usage: ./collision_check
+ */
+#include "../CS3113/Collision.h"
+#include "../CS3113/cs3113.h"
+
+#include <cstring>
+
+// The batch sizes cover empty and single batches, partial SIMD blocks and
+// both sides of each 32-bit hit mask word
+constexpr int COLLISION_CHECK_COUNTS[] = {0, 1, 3, 7, 31, 33, 65};
+constexpr int COLLISION_CHECK_MAX_COUNT = 65;
+constexpr int COLLISION_CHECK_MASK_WORDS = (COLLISION_CHECK_MAX_COUNT + 31) / 32;
+constexpr int COLLISION_CHECK_TRIALS = 200;
+
+/**
+ * @brief Tests one box against `count` others with `BoxOverlapBatch()`,
+ * under whichever kernel is selected, and with `BoxOverlapBatchScalar()`.
+ *
+ * @return false if the hit counts, hit masks or either overlap array differ
+ * in any bit
+ */
+bool batchMatchesScalar(Vector2 position, Vector2 size,
+                        const Vector2 *positions, const Vector2 *dimensions,
+                        int count) {
+  unsigned int mask[COLLISION_CHECK_MASK_WORDS];
+  unsigned int expectedMask[COLLISION_CHECK_MASK_WORDS];
+  float xOverlaps[COLLISION_CHECK_MAX_COUNT + 1];
+  float yOverlaps[COLLISION_CHECK_MAX_COUNT + 1];
+  float expectedX[COLLISION_CHECK_MAX_COUNT + 1];
+  float expectedY[COLLISION_CHECK_MAX_COUNT + 1];
+
+  int hits = BoxOverlapBatch(position, size, positions, dimensions, count,
+                             mask, xOverlaps, yOverlaps);
+  int expectedHits =
+      BoxOverlapBatchScalar(position, size, positions, dimensions, count,
+                            expectedMask, expectedX, expectedY);
+
+  return hits == expectedHits &&
+         memcmp(mask, expectedMask,
+                HitMaskWords(count) * sizeof(unsigned int)) == 0 &&
+         memcmp(xOverlaps, expectedX, count * sizeof(float)) == 0 &&
+         memcmp(yOverlaps, expectedY, count * sizeof(float)) == 0;
+}
+
+/**
+ * @brief A box to test against the one at `centre` (`size` across): random
+ * most of the time, otherwise one of the cases most likely to split the
+ * kernels. Those are boxes exactly touching it on either axis, so an overlap
+ * of exactly zero; negative zeros; and coordinates large enough to lose
+ * every bit of the box sizes. Random coordinates are hundredths, which
+ * round, or whole quarters, which don't, so touching boxes on the quarter
+ * grid come out exact.
+ */
+void collisionCheckBox(unsigned int &state, Vector2 centre, Vector2 size,
+                       Vector2 *position, Vector2 *dimensions) {
+  float steps = RandomInt(state, 0, 1) ? 4.0f : 100.0f;
+  *dimensions = {RandomInt(state, 0, 200 * (int)steps) / steps,
+                 RandomInt(state, 0, 200 * (int)steps) / steps};
+  *position = {RandomInt(state, -200 * (int)steps, 200 * (int)steps) / steps,
+               RandomInt(state, -200 * (int)steps, 200 * (int)steps) / steps};
+  float touchX = (size.x + dimensions->x) * 0.5f;
+  float touchY = (size.y + dimensions->y) * 0.5f;
+
+  switch (RandomInt(state, 0, 7)) {
+  case 0:
+    position->x = centre.x + (RandomInt(state, 0, 1) ? touchX : -touchX);
+    position->y = centre.y;
+    break;
+  case 1:
+    position->x = centre.x;
+    position->y = centre.y + (RandomInt(state, 0, 1) ? touchY : -touchY);
+    break;
+  case 2:
+    *position = {-0.0f, RandomInt(state, 0, 1) ? -0.0f : centre.y};
+    if (RandomInt(state, 0, 1))
+      *dimensions = {-0.0f, -0.0f};
+    break;
+  case 3:
+    position->x = RandomInt(state, 0, 1) ? 3.0e38f : -3.0e38f;
+    position->y = RandomInt(state, 0, 1) ? 1.0e30f : centre.y;
+    break;
+  default:
+    break;
+  }
+}
+
+/**
+ * @brief Checks every collision kernel the CPU supports against the scalar
+ * one, on random boxes and edge cases at every size in
+ * `COLLISION_CHECK_COUNTS`, and one `BoxOverlapMatrix()` against a row of
+ * scalar batches. Kernels the CPU lacks are reported and skipped.
+ *
+ * @return false if any kernel differed in any bit
+ */
+bool checkCollisionKernels() {
+  const CollisionKernel kernels[] = {KERNEL_SCALAR, KERNEL_SSE, KERNEL_AVX2};
+  CollisionKernel detected = GetCollisionKernel();
+  bool allMatched = true;
+
+  for (CollisionKernel kernel : kernels) {
+    SetCollisionKernel(kernel);
+    if (GetCollisionKernel() != kernel) {
+      LOG("collision kernel " << GetCollisionKernelName(kernel)
+                              << ": not supported here, skipped");
+      continue;
+    }
+
+    unsigned int state = 1;
+    int batches = 0, mismatches = 0;
+    Vector2 positions[COLLISION_CHECK_MAX_COUNT + 1];
+    Vector2 dimensions[COLLISION_CHECK_MAX_COUNT + 1];
+
+    for (int count : COLLISION_CHECK_COUNTS) {
+      for (int trial = 0; trial < COLLISION_CHECK_TRIALS; trial++) {
+        Vector2 position, size;
+        collisionCheckBox(state, {0.0f, 0.0f}, {0.0f, 0.0f}, &position,
+                          &size);
+        for (int i = 0; i < count; i++)
+          collisionCheckBox(state, position, size, &positions[i],
+                            &dimensions[i]);
+
+        batches++;
+        mismatches +=
+            !batchMatchesScalar(position, size, positions, dimensions, count);
+      }
+    }
+
+    // A 5 x 33 matrix is five batches into consecutive rows of one mask
+    constexpr int ROWS = 5, COLUMNS = 33, WORDS = (COLUMNS + 31) / 32;
+    Vector2 rowPositions[ROWS], rowDimensions[ROWS];
+    for (int r = 0; r < ROWS; r++)
+      collisionCheckBox(state, {0.0f, 0.0f}, {0.0f, 0.0f}, &rowPositions[r],
+                        &rowDimensions[r]);
+    for (int i = 0; i < COLUMNS; i++)
+      collisionCheckBox(state, rowPositions[i % ROWS], rowDimensions[i % ROWS],
+                        &positions[i], &dimensions[i]);
+
+    unsigned int matrix[ROWS * WORDS], expectedRow[WORDS];
+    float xScratch[COLUMNS], yScratch[COLUMNS];
+    float expectedX[COLUMNS], expectedY[COLUMNS];
+    int hits = BoxOverlapMatrix(rowPositions, rowDimensions, ROWS, positions,
+                                dimensions, COLUMNS, matrix, xScratch,
+                                yScratch);
+    int expectedHits = 0;
+    bool matrixMatched = true;
+    for (int r = 0; r < ROWS; r++) {
+      expectedHits += BoxOverlapBatchScalar(
+          rowPositions[r], rowDimensions[r], positions, dimensions, COLUMNS,
+          expectedRow, expectedX, expectedY);
+      matrixMatched = matrixMatched &&
+                      memcmp(matrix + r * WORDS, expectedRow,
+                             sizeof(expectedRow)) == 0;
+    }
+    // The scratch arrays are left holding the last row's overlaps
+    matrixMatched = matrixMatched && hits == expectedHits &&
+                    memcmp(xScratch, expectedX, sizeof(xScratch)) == 0 &&
+                    memcmp(yScratch, expectedY, sizeof(yScratch)) == 0;
+    batches++;
+    mismatches += !matrixMatched;
+
+    LOG("collision kernel " << GetCollisionKernelName(kernel) << ": "
+                            << batches << " batches, " << mismatches
+                            << " mismatched");
+    allMatched = allMatched && mismatches == 0;
+  }
+
+  SetCollisionKernel(detected);
+  return allMatched;
+}
+
+int main() {
+  if (checkCollisionKernels())
+    return 0;
+  LOG("Collision check failed: a SIMD kernel disagreed with the scalar one");
+  return 1;
+}
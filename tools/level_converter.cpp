@@ -0,0 +1,292 @@
+/**
+ * Offline converter from the human-editable level text form (levels/<name>.txt)
+ * to the binary format in CS3113/LevelFormat.h that the game maps at load.
+ *
+ * Usage: ./level_converter <level.txt> <level.lvl>
+ *
+ * Text form, one directive per line, `#` starts a comment:
+ *
+ *   entity <PLAYER|BLOCK|PLATFORM|ENEMY|NONE>
+ *     texture <path>
+ *     position <x> <y>                        fixed spawn point
+ *     spawn <min x> <max x> <min y> <max y>   random spawn point
+ *     scale <width> <height>
+ *     patrol_speed <speed>                    default 2
+ *     path <PING_PONG|LOOP|SPLINE> <x> <y> ... patrol waypoints, at least 2
+ *     bounciness <value>                      default: the entity's own
+ *     sensor <width> <height>                 trigger volume, default none
+ *     layer <render layer>                    default 0
+ *     sheet <x> <y>                           sprite-sheet dimensions
+ *     frame_speed <frames per second>         default: the entity's own
+ *     clip <LEFT|UP|RIGHT|DOWN> <frame> ...   one line per direction
+ *   end
+ *
+ * An entity with a `sheet` is animated and needs a `clip` line for every
+ * direction. `path` waypoints are offsets from
+ * the spawn point; platforms and enemies without one patrol from edge to
+ * edge of the screen.
+ */
+#include "../CS3113/LevelFormat.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Must match the `EntityType`, `Direction` and `PatrolKind` enums (checked
+// in Level.cpp)
+const char *const ENTITY_TYPES[] = {"PLAYER", "BLOCK", "PLATFORM", "ENEMY",
+                                    "NONE"};
+const char *const DIRECTIONS[LEVEL_DIRECTIONS] = {"LEFT", "UP", "RIGHT",
+                                                  "DOWN"};
+const char *const PATROL_KINDS[] = {"PING_PONG", "LOOP", "SPLINE"};
+constexpr float DEFAULT_PATROL_SPEED = 2.0f;
+
+struct ParsedEntity {
+  LevelEntity record;
+  std::string texture;
+  bool isAnimated = false;
+  std::vector<uint16_t> clips[LEVEL_DIRECTIONS];
+  std::vector<float> points;
+};
+
+int findName(const char *const *names, int count, const std::string &name) {
+  for (int i = 0; i < count; i++)
+    if (name == names[i])
+      return i;
+  return -1;
+}
+
+bool fail(const char *filepath, int line, const std::string &message) {
+  std::cerr << filepath << ":" << line << ": " << message << '\n';
+  return false;
+}
+
+bool parseLevel(const char *filepath, std::vector<ParsedEntity> &entities) {
+  std::ifstream input(filepath);
+  if (!input)
+    return fail(filepath, 0, "cannot open file");
+
+  ParsedEntity *current = nullptr;
+  std::string text;
+  int line = 0;
+
+  while (std::getline(input, text)) {
+    line++;
+    size_t comment = text.find('#');
+    if (comment != std::string::npos)
+      text.erase(comment);
+
+    std::istringstream words(text);
+    std::string keyword;
+    if (!(words >> keyword))
+      continue;
+
+    if (keyword == "entity") {
+      if (current)
+        return fail(filepath, line, "missing 'end' before 'entity'");
+
+      std::string typeName;
+      words >> typeName;
+      int type = findName(ENTITY_TYPES, 5, typeName);
+      if (type < 0)
+        return fail(filepath, line, "unknown entity type '" + typeName + "'");
+
+      entities.push_back(ParsedEntity());
+      current = &entities.back();
+      memset(&current->record, 0, sizeof(current->record));
+      current->record.type = (uint8_t)type;
+      current->record.patrolSpeed = DEFAULT_PATROL_SPEED;
+      current->record.bounciness = -1.0f;
+      current->record.clipIndex = -1;
+      continue;
+    }
+
+    if (!current)
+      return fail(filepath, line, "'" + keyword + "' outside an entity");
+
+    LevelEntity &record = current->record;
+    bool ok = true;
+
+    if (keyword == "end") {
+      if (current->texture.empty())
+        return fail(filepath, line, "entity has no texture");
+      for (int d = 0; current->isAnimated && d < LEVEL_DIRECTIONS; d++)
+        if (current->clips[d].empty())
+          return fail(filepath, line,
+                      std::string("animated entity has no clip for ") +
+                          DIRECTIONS[d]);
+      current = nullptr;
+    } else if (keyword == "texture") {
+      ok = static_cast<bool>(words >> current->texture);
+    } else if (keyword == "position") {
+      ok = static_cast<bool>(words >> record.spawnMin[0] >> record.spawnMin[1]);
+      record.spawnMax[0] = record.spawnMin[0];
+      record.spawnMax[1] = record.spawnMin[1];
+    } else if (keyword == "spawn") {
+      ok = static_cast<bool>(words >> record.spawnMin[0] >> record.spawnMax[0] >>
+                             record.spawnMin[1] >> record.spawnMax[1]);
+    } else if (keyword == "scale") {
+      ok = static_cast<bool>(words >> record.scale[0] >> record.scale[1]);
+    } else if (keyword == "patrol_speed") {
+      ok = static_cast<bool>(words >> record.patrolSpeed);
+    } else if (keyword == "bounciness") {
+      ok = static_cast<bool>(words >> record.bounciness);
+    } else if (keyword == "sensor") {
+      ok = static_cast<bool>(words >> record.sensor[0] >> record.sensor[1]) &&
+           record.sensor[0] > 0.0f && record.sensor[1] > 0.0f;
+    } else if (keyword == "layer" || keyword == "frame_speed") {
+      int value;
+      ok = static_cast<bool>(words >> value) && value >= 0 && value < 256;
+      (keyword == "layer" ? record.renderLayer : record.frameSpeed) =
+          (uint8_t)value;
+    } else if (keyword == "sheet") {
+      int x, y;
+      ok = static_cast<bool>(words >> x >> y) && x > 0 && x < 256 && y > 0 &&
+           y < 256;
+      record.sheetDimensions[0] = (uint8_t)x;
+      record.sheetDimensions[1] = (uint8_t)y;
+      current->isAnimated = true;
+    } else if (keyword == "clip") {
+      std::string directionName;
+      words >> directionName;
+      int direction = findName(DIRECTIONS, LEVEL_DIRECTIONS, directionName);
+      if (direction < 0)
+        return fail(filepath, line, "unknown direction '" + directionName + "'");
+
+      int frame;
+      current->clips[direction].clear();
+      while (words >> frame && frame >= 0 && frame < 65536)
+        current->clips[direction].push_back((uint16_t)frame);
+      ok = words.eof() && !current->clips[direction].empty();
+    } else if (keyword == "path") {
+      std::string kindName;
+      words >> kindName;
+      int kind = findName(PATROL_KINDS, 3, kindName);
+      if (kind < 0)
+        return fail(filepath, line, "unknown path kind '" + kindName + "'");
+
+      float x, y;
+      record.pathKind = (uint8_t)kind;
+      current->points.clear();
+      while (words >> x >> y) {
+        current->points.push_back(x);
+        current->points.push_back(y);
+      }
+      ok = words.eof() && current->points.size() >= 4 &&
+           current->points.size() / 2 < 65536;
+    } else {
+      return fail(filepath, line, "unknown directive '" + keyword + "'");
+    }
+
+    if (!ok)
+      return fail(filepath, line, "bad arguments to '" + keyword + "'");
+  }
+
+  if (current)
+    return fail(filepath, line, "missing 'end' at end of file");
+  return true;
+}
+
+size_t alignTo4(size_t offset) { return (offset + 3) & ~(size_t)3; }
+
+bool writeLevel(const char *filepath, std::vector<ParsedEntity> &entities) {
+  std::vector<LevelClip> clips;
+  std::vector<uint16_t> frames;
+  std::vector<float> points;
+  std::string strings;
+
+  for (ParsedEntity &entity : entities) {
+    size_t existing = strings.find(entity.texture + '\0');
+    if (existing == std::string::npos || (existing > 0 && strings[existing - 1] != '\0')) {
+      existing = strings.size();
+      strings += entity.texture;
+      strings += '\0';
+    }
+    entity.record.textureOffset = (uint32_t)existing;
+
+    if ((points.size() + entity.points.size()) / 2 > 65535)
+      return false;
+    entity.record.firstPoint = (uint16_t)(points.size() / 2);
+    entity.record.pointCount = (uint16_t)(entity.points.size() / 2);
+    points.insert(points.end(), entity.points.begin(), entity.points.end());
+
+    if (!entity.isAnimated)
+      continue;
+
+    LevelClip clip;
+    for (int d = 0; d < LEVEL_DIRECTIONS; d++) {
+      clip.firstFrame[d] = (uint16_t)frames.size();
+      clip.frameCount[d] = (uint16_t)entity.clips[d].size();
+      frames.insert(frames.end(), entity.clips[d].begin(),
+                    entity.clips[d].end());
+    }
+    entity.record.clipIndex = (int16_t)clips.size();
+    clips.push_back(clip);
+  }
+
+  LevelHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = LEVEL_MAGIC;
+  header.version = LEVEL_VERSION;
+  header.headerSize = sizeof(LevelHeader);
+  header.entityCount = (uint32_t)entities.size();
+  header.entityOffset = (uint32_t)alignTo4(sizeof(LevelHeader));
+  header.clipCount = (uint32_t)clips.size();
+  header.clipOffset = (uint32_t)alignTo4(
+      header.entityOffset + entities.size() * sizeof(LevelEntity));
+  header.frameCount = (uint32_t)frames.size();
+  header.frameOffset =
+      (uint32_t)alignTo4(header.clipOffset + clips.size() * sizeof(LevelClip));
+  header.pointCount = (uint32_t)(points.size() / 2);
+  header.pointOffset = (uint32_t)alignTo4(header.frameOffset +
+                                          frames.size() * sizeof(uint16_t));
+  header.stringBytes = (uint32_t)strings.size();
+  header.stringOffset = (uint32_t)alignTo4(header.pointOffset +
+                                           points.size() * sizeof(float));
+
+  std::vector<unsigned char> file(header.stringOffset + strings.size(), 0);
+  memcpy(&file[0], &header, sizeof(header));
+  for (size_t i = 0; i < entities.size(); i++)
+    memcpy(&file[header.entityOffset + i * sizeof(LevelEntity)],
+           &entities[i].record, sizeof(LevelEntity));
+  if (!clips.empty())
+    memcpy(&file[header.clipOffset], clips.data(),
+           clips.size() * sizeof(LevelClip));
+  if (!frames.empty())
+    memcpy(&file[header.frameOffset], frames.data(),
+           frames.size() * sizeof(uint16_t));
+  if (!points.empty())
+    memcpy(&file[header.pointOffset], points.data(),
+           points.size() * sizeof(float));
+  memcpy(&file[header.stringOffset], strings.data(), strings.size());
+
+  FILE *output = fopen(filepath, "wb");
+  if (!output)
+    return false;
+  bool ok = fwrite(file.data(), 1, file.size(), output) == file.size();
+  return fclose(output) == 0 && ok;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <level.txt> <level.lvl>\n";
+    return 2;
+  }
+
+  std::vector<ParsedEntity> entities;
+  if (!parseLevel(argv[1], entities))
+    return 1;
+
+  if (!writeLevel(argv[2], entities)) {
+    std::cerr << argv[2] << ": cannot write file\n";
+    return 1;
+  }
+
+  std::cout << argv[1] << " -> " << argv[2] << " (" << entities.size()
+            << " entities)\n";
+  return 0;
+}
@@ -0,0 +1,194 @@
+/**
+ * Bakes every texture the game draws into the GPU-ready form in
+ * CS3113/BakedTexture.h, scaled down to the largest size it is ever drawn
+ * at. Display sizes come from the compiled levels: each entity's scale is
+ * the size of one sprite-sheet frame, so sheets are scaled frame by frame
+ * and keep their row and column layout. Images that aren't in a level (the
+ * background) are given with `--display`. Nothing is ever scaled up.
+ *
+ * Usage: ./texture_baker <level.lvl>... [--display <image> <width> <height>]...
+ *
+ * Baked files go in a baked/ directory next to each source image, which
+ * must already exist.
+ */
+#include "../CS3113/BakedTexture.h"
+#include "../CS3113/LevelFormat.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+struct BakeTarget {
+  int rows = 1, cols = 1;            // sprite-sheet layout
+  float width = 0.0f, height = 0.0f; // largest size a frame is drawn at
+};
+
+bool addTarget(std::map<std::string, BakeTarget> &targets,
+               const std::string &filepath, int rows, int cols, float width,
+               float height) {
+  std::map<std::string, BakeTarget>::iterator found = targets.find(filepath);
+  if (found == targets.end()) {
+    BakeTarget target;
+    target.rows = rows;
+    target.cols = cols;
+    found = targets.insert(std::make_pair(filepath, target)).first;
+  }
+
+  BakeTarget &target = found->second;
+  if (target.rows != rows || target.cols != cols) {
+    std::cerr << filepath << ": used with two sprite-sheet layouts\n";
+    return false;
+  }
+  target.width = fmaxf(target.width, fabsf(width));
+  target.height = fmaxf(target.height, fabsf(height));
+  return true;
+}
+
+/**
+ * Adds every texture `filepath` uses, at the size each of its entities is
+ * drawn at. The level is only read, so a light check is enough here; the
+ * game validates levels fully when it loads them.
+ */
+bool readLevel(const char *filepath,
+               std::map<std::string, BakeTarget> &targets) {
+  std::ifstream input(filepath, std::ios::binary);
+  std::vector<char> file((std::istreambuf_iterator<char>(input)),
+                         std::istreambuf_iterator<char>());
+
+  LevelHeader header;
+  if (file.size() < sizeof(header)) {
+    std::cerr << filepath << ": not a level\n";
+    return false;
+  }
+  memcpy(&header, file.data(), sizeof(header));
+
+  if (header.magic != LEVEL_MAGIC || header.version != LEVEL_VERSION ||
+      header.entityOffset + (size_t)header.entityCount * sizeof(LevelEntity) >
+          file.size() ||
+      header.stringOffset + (size_t)header.stringBytes > file.size() ||
+      header.stringBytes == 0 ||
+      file[header.stringOffset + header.stringBytes - 1] != '\0') {
+    std::cerr << filepath << ": not a level of version " << LEVEL_VERSION
+              << '\n';
+    return false;
+  }
+
+  for (uint32_t i = 0; i < header.entityCount; i++) {
+    LevelEntity entity;
+    memcpy(&entity, &file[header.entityOffset + i * sizeof(LevelEntity)],
+           sizeof(entity));
+    if (entity.textureOffset >= header.stringBytes)
+      return false;
+
+    bool isSheet = entity.clipIndex >= 0;
+    std::string texture = &file[header.stringOffset + entity.textureOffset];
+    if (!addTarget(targets, texture, isSheet ? entity.sheetDimensions[0] : 1,
+                   isSheet ? entity.sheetDimensions[1] : 1, entity.scale[0],
+                   entity.scale[1]))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Decodes `filepath` and returns it as R8G8B8A8 with each frame no larger
+ * than `target` says it is drawn. `sourceSize` receives the decoded size.
+ */
+Image bakeImage(const char *filepath, const BakeTarget &target,
+                Vector2 *sourceSize) {
+  Image source = LoadImage(filepath);
+  *sourceSize = {(float)source.width, (float)source.height};
+  if (source.data == NULL)
+    return source;
+  ImageFormat(&source, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+  int sourceFrameWidth = source.width / target.cols;
+  int sourceFrameHeight = source.height / target.rows;
+  int frameWidth = std::min(sourceFrameWidth, (int)ceilf(target.width));
+  int frameHeight = std::min(sourceFrameHeight, (int)ceilf(target.height));
+  if (frameWidth < 1 || frameHeight < 1) {
+    frameWidth = sourceFrameWidth;
+    frameHeight = sourceFrameHeight;
+  }
+
+  if (target.rows == 1 && target.cols == 1) {
+    if (frameWidth != source.width || frameHeight != source.height)
+      ImageResize(&source, frameWidth, frameHeight);
+    return source;
+  }
+
+  // Scale each frame on its own so no frame bleeds into its neighbours
+  Image baked = GenImageColor(frameWidth * target.cols,
+                              frameHeight * target.rows, BLANK);
+  for (int row = 0; row < target.rows; row++) {
+    for (int col = 0; col < target.cols; col++) {
+      Rectangle sourceFrame = {(float)(col * sourceFrameWidth),
+                               (float)(row * sourceFrameHeight),
+                               (float)sourceFrameWidth,
+                               (float)sourceFrameHeight};
+      Image frame = ImageFromImage(source, sourceFrame);
+      ImageResize(&frame, frameWidth, frameHeight);
+
+      Rectangle whole = {0.0f, 0.0f, (float)frameWidth, (float)frameHeight};
+      Rectangle destination = {(float)(col * frameWidth),
+                               (float)(row * frameHeight), (float)frameWidth,
+                               (float)frameHeight};
+      ImageDraw(&baked, frame, whole, destination, WHITE);
+      UnloadImage(frame);
+    }
+  }
+  UnloadImage(source);
+  return baked;
+}
+
+int main(int argc, char *argv[]) {
+  std::map<std::string, BakeTarget> targets;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--display") == 0 && i + 3 < argc) {
+      if (!addTarget(targets, argv[i + 1], 1, 1, (float)atof(argv[i + 2]),
+                     (float)atof(argv[i + 3])))
+        return 1;
+      i += 3;
+    } else if (!readLevel(argv[i], targets)) {
+      return 1;
+    }
+  }
+
+  if (targets.empty()) {
+    std::cerr << "Usage: " << argv[0]
+              << " <level.lvl>... [--display <image> <width> <height>]...\n";
+    return 2;
+  }
+
+  SetTraceLogLevel(LOG_WARNING);
+  size_t sourceBytes = 0, bakedBytes = 0;
+
+  for (const std::pair<const std::string, BakeTarget> &target : targets) {
+    const char *filepath = target.first.c_str();
+    Vector2 sourceSize;
+    Image baked = bakeImage(filepath, target.second, &sourceSize);
+    std::string bakedFilepath = GetBakedTexturePath(filepath);
+
+    if (baked.data == NULL || !SaveBakedImage(bakedFilepath.c_str(), baked)) {
+      std::cerr << filepath << ": cannot bake to " << bakedFilepath << '\n';
+      UnloadImage(baked);
+      return 1;
+    }
+
+    sourceBytes += (size_t)(sourceSize.x * sourceSize.y) * 4;
+    bakedBytes += (size_t)baked.width * baked.height * 4;
+    std::cout << filepath << " " << sourceSize.x << "x" << sourceSize.y
+              << " -> " << bakedFilepath << " " << baked.width << "x"
+              << baked.height << '\n';
+    UnloadImage(baked);
+  }
+
+  std::cout << "Baked " << targets.size() << " textures: "
+            << sourceBytes / 1024 << " KiB -> " << bakedBytes / 1024
+            << " KiB of pixels\n";
+  return 0;
+}